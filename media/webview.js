@@ -9,12 +9,33 @@ const ctx = canvas.getContext('2d');
 
 // World state
 let world = null;
-const CELL_SIZE = 40;
+let beeperMap = new Map(); // "x,y" -> count, patched by worldDelta messages
+let staticLayer = null; // Offscreen canvas: background, labels, grid, walls, border
+let staticLayerKey = null; // Walls, canvas size, camera and theme the static layer was built for
+let wallsVersion = 0; // Bumped whenever the walls are re-indexed
+let drawnKarel = null; // Cell where Karel was last drawn
+let wallsByRow = new Map(); // lower row -> walls touching it
+let worldSize = null; // "width x height" of the map the camera was fitted to
+let renderPending = false;
+let drag = null; // Pointer and camera position when a pan started
+const CELL_SIZE = 40; // Default (and fit-to-panel maximum) cell size
+const MIN_CELL_SIZE = 2;
+const MAX_CELL_SIZE = 80;
+const MIN_GRID_CELL_SIZE = 6; // Below this, grid lines are not drawn
+const MIN_LABEL_SPACING = 24; // Minimum distance between axis labels in pixels
+const MAX_CANVAS_SIZE = 4096; // Stay well below browser canvas limits
+const ZOOM_FACTOR = 1.15;
+const FOLLOW_MARGIN = 2; // Cells kept between Karel and the edge when following
 const WALL_WIDTH = 4;
 const AXIS_MARGIN = 25; // Space for axis labels
+const CANVAS_BORDER = 2; // Matches #worldCanvas border in webview.css
+
+// Camera: cell size in pixels and the world offset (in cells) of the bottom-left corner of the view
+const camera = { cellSize: CELL_SIZE, x: 0, y: 0 };
 
 // UI Elements
 const runBtn = document.getElementById('runBtn');
+const backBtn = document.getElementById('backBtn');
 const stepBtn = document.getElementById('stepBtn');
 const stopBtn = document.getElementById('stopBtn');
 const resetBtn = document.getElementById('resetBtn');
@@ -22,9 +43,16 @@ const changeProgramBtn = document.getElementById('changeProgramBtn');
 const statusEl = document.getElementById('status');
 const speedSlider = document.getElementById('speed');
 const speedValue = document.getElementById('speedValue');
+const followCheckbox = document.getElementById('followKarel');
+const timelineEl = document.getElementById('timeline');
+const timelineSlider = document.getElementById('timelineSlider');
+const timelineLabel = document.getElementById('timelineLabel');
+const timelineEnd = document.getElementById('timelineEnd');
+let timelineDragging = false; // Ignore position updates while the user scrubs
 
 // Button handlers
 runBtn.addEventListener('click', () => vscode.postMessage({ command: 'run' }));
+backBtn.addEventListener('click', () => vscode.postMessage({ command: 'stepBack' }));
 stepBtn.addEventListener('click', () => vscode.postMessage({ command: 'step' }));
 stopBtn.addEventListener('click', () => vscode.postMessage({ command: 'stop' }));
 resetBtn.addEventListener('click', () => vscode.postMessage({ command: 'reset' }));
@@ -36,6 +64,24 @@ speedSlider.addEventListener('input', (e) => {
   vscode.postMessage({ command: 'speedChange', data: speed });
 });
 
+followCheckbox.addEventListener('change', () => {
+  if (world && followCheckbox.checked && followKarel()) {
+    render();
+  }
+});
+
+timelineSlider.addEventListener('input', () => {
+  const step = parseInt(timelineSlider.value, 10);
+  updateTimelineLabel(step);
+  vscode.postMessage({ command: 'seekTimeline', data: step });
+});
+timelineSlider.addEventListener('pointerdown', () => {
+  timelineDragging = true;
+});
+window.addEventListener('pointerup', () => {
+  timelineDragging = false;
+});
+
 // Handle messages from extension
 window.addEventListener('message', (event) => {
   const message = event.data;
@@ -43,19 +89,106 @@ window.addEventListener('message', (event) => {
   switch (message.type) {
     case 'updateWorld':
       world = message.data;
+      setBeepers(world.beepers);
+      indexWalls();
+      // Only refit the camera when a differently sized map arrives
+      const size = world.dimensions.width + 'x' + world.dimensions.height;
+      if (size !== worldSize) {
+        worldSize = size;
+        fitCamera();
+      }
+      if (followCheckbox.checked) {
+        resizeCanvas();
+        followKarel();
+      }
+      render();
+      updateInfoPanel();
+      updateModifiedIndicator(message.isModified);
+      break;
+    case 'worldState':
+      // Karel and every beeper; the walls and camera are kept
+      if (!world) break;
+      world.karel = message.data.karel;
+      setBeepers(message.data.beepers);
+      if (followCheckbox.checked) {
+        resizeCanvas();
+        followKarel();
+      }
       render();
       updateInfoPanel();
       updateModifiedIndicator(message.isModified);
       break;
+    case 'worldDelta': {
+      const dirty = applyDelta(message.data);
+      if (followCheckbox.checked && followKarel()) {
+        render();
+      } else {
+        renderCells(dirty);
+      }
+      updateInfoPanel();
+      updateModifiedIndicator(message.isModified);
+      break;
+    }
     case 'status':
       setStatus(message.status, message.message);
       break;
+    case 'timeline':
+      showTimeline(message.total, message.end);
+      break;
+    case 'timelinePosition':
+      if (!timelineDragging) {
+        timelineSlider.value = message.step;
+        updateTimelineLabel(message.step);
+      }
+      break;
+    case 'hideTimeline':
+      if (!timelineEl.hidden) {
+        timelineEl.hidden = true;
+        render();
+      }
+      break;
     case 'highlightLine':
       // Could highlight line number in info panel
       break;
   }
 });
 
+/**
+ * Replace every beeper count.
+ */
+function setBeepers(beepers) {
+  beeperMap = new Map();
+  for (const beeper of beepers) {
+    beeperMap.set(beeper.x + ',' + beeper.y, beeper.count);
+  }
+}
+
+/**
+ * Apply incremental changes (Karel pose and changed beeper cells) to the current world.
+ * Returns the cells that need repainting.
+ */
+function applyDelta(delta) {
+  if (!world) return [];
+
+  const dirty = [];
+  if (drawnKarel) {
+    dirty.push(drawnKarel);
+  }
+  dirty.push({ x: delta.karel.x, y: delta.karel.y });
+
+  world.karel = delta.karel;
+  for (const beeper of delta.beepers) {
+    const key = beeper.x + ',' + beeper.y;
+    if (beeper.count > 0) {
+      beeperMap.set(key, beeper.count);
+    } else {
+      beeperMap.delete(key);
+    }
+    dirty.push({ x: beeper.x, y: beeper.y });
+  }
+  return dirty;
+}
+
 function setStatus(status, message) {
   statusEl.className = 'status ' + status;
   statusEl.textContent = message || status.charAt(0).toUpperCase() + status.slice(1);
@@ -63,9 +196,39 @@ function setStatus(status, message) {
   const isRunning = status === 'running';
   runBtn.disabled = isRunning;
   stepBtn.disabled = isRunning;
+  backBtn.disabled = isRunning;
   stopBtn.disabled = !isRunning;
 }
 
+/**
+ * Show the timeline of a precomputed run or replayed trace, with how the run
+ * ends flagged at its end.
+ */
+function showTimeline(total, end) {
+  timelineSlider.max = total;
+  timelineSlider.value = 0;
+  updateTimelineLabel(0);
+
+  timelineEnd.className = 'timeline-end ' + end.status;
+  if (end.status === 'error') {
+    timelineEnd.textContent = '⚠ ' + end.message;
+  } else if (end.status === 'completed') {
+    timelineEnd.textContent = '✓ Completes';
+  } else {
+    timelineEnd.textContent = 'Incomplete';
+  }
+  timelineEnd.title = end.message || timelineEnd.textContent;
+
+  if (timelineEl.hidden) {
+    timelineEl.hidden = false;
+    render(); // The canvas area got shorter
+  }
+}
+
+function updateTimelineLabel(step) {
+  timelineLabel.textContent = step + ' / ' + timelineSlider.max;
+}
+
 function updateModifiedIndicator(isModified) {
   if (isModified) {
     runBtn.classList.add('modified');
@@ -89,131 +252,492 @@ function updateInfoPanel() {
   document.getElementById('beepers').textContent = world.karel.beepers.toString();
 }
 
+/**
+ * Full render: fit the canvas to the panel, rebuild the static layer for the
+ * visible part of the map if the walls, canvas size, camera or theme changed,
+ * then draw visible beepers and Karel on top of it.
+ */
 function render() {
   if (!world) return;
 
+  resizeCanvas();
+  clampCamera();
+  const key = [
+    wallsVersion,
+    canvas.width,
+    canvas.height,
+    camera.cellSize,
+    camera.x,
+    camera.y,
+    document.body.className,
+  ].join(' ');
+  if (key !== staticLayerKey) {
+    buildStaticLayer();
+    staticLayerKey = key;
+  }
+  ctx.drawImage(staticLayer, 0, 0);
+
+  const range = visibleRange();
+  ctx.save();
+  clipToGrid();
+  const visibleCells = (range.maxX - range.minX + 1) * (range.maxY - range.minY + 1);
+  if (beeperMap.size <= visibleCells) {
+    for (const [key, count] of beeperMap) {
+      const [x, y] = key.split(',').map(Number);
+      if (isInRange(range, x, y)) {
+        drawBeeper(x, y, count);
+      }
+    }
+  } else {
+    for (let y = range.minY; y <= range.maxY; y++) {
+      for (let x = range.minX; x <= range.maxX; x++) {
+        const count = beeperMap.get(x + ',' + y);
+        if (count) {
+          drawBeeper(x, y, count);
+        }
+      }
+    }
+  }
+  drawKarel(world.karel);
+  ctx.restore();
+  drawnKarel = { x: world.karel.x, y: world.karel.y };
+}
+
+/**
+ * Incremental render: repaint only the given cells from the static layer,
+ * then redraw their beepers and Karel if he stands on one of them.
+ */
+function renderCells(cells) {
+  if (!world || !staticLayer) {
+    render();
+    return;
+  }
+
+  const range = visibleRange();
+  const seen = new Set();
+  ctx.save();
+  clipToGrid();
+  for (const cell of cells) {
+    const key = cell.x + ',' + cell.y;
+    if (seen.has(key) || !isInRange(range, cell.x, cell.y)) continue;
+    seen.add(key);
+
+    const { left, top, size } = cellRect(cell.x, cell.y);
+    ctx.drawImage(staticLayer, left, top, size, size, left, top, size, size);
+
+    const count = beeperMap.get(key);
+    if (count) {
+      drawBeeper(cell.x, cell.y, count);
+    }
+  }
+
+  drawKarel(world.karel);
+  ctx.restore();
+  drawnKarel = { x: world.karel.x, y: world.karel.y };
+}
+
+/**
+ * Coalesce pan, zoom and resize events into one render per frame.
+ */
+function scheduleRender() {
+  if (renderPending) return;
+  renderPending = true;
+  requestAnimationFrame(() => {
+    renderPending = false;
+    render();
+  });
+}
+
+function isInRange(range, x, y) {
+  return x >= range.minX && x <= range.maxX && y >= range.minY && y <= range.maxY;
+}
+
+// ===== Viewport =====
+
+/**
+ * Size of the grid area on the canvas, excluding axis labels and border walls.
+ */
+function viewSize() {
+  return {
+    viewWidth: canvas.width - AXIS_MARGIN - WALL_WIDTH * 2,
+    viewHeight: canvas.height - AXIS_MARGIN - WALL_WIDTH * 2,
+  };
+}
+
+/**
+ * Size the canvas to the smaller of the panel and the zoomed world,
+ * never exceeding MAX_CANVAS_SIZE.
+ */
+function resizeCanvas() {
   const { width, height } = world.dimensions;
+  const available = availableSize();
+  const cs = camera.cellSize;
 
-  // Resize canvas with space for axis labels (left and bottom)
-  canvas.width = AXIS_MARGIN + width * CELL_SIZE + WALL_WIDTH * 2;
-  canvas.height = AXIS_MARGIN + height * CELL_SIZE + WALL_WIDTH * 2;
+  const canvasWidth = Math.min(
+    available.width,
+    MAX_CANVAS_SIZE,
+    Math.ceil(width * cs) + AXIS_MARGIN + WALL_WIDTH * 2
+  );
+  const canvasHeight = Math.min(
+    available.height,
+    MAX_CANVAS_SIZE,
+    Math.ceil(height * cs) + AXIS_MARGIN + WALL_WIDTH * 2
+  );
 
-  // Grid starts after the axis margin
-  const gridOffsetX = AXIS_MARGIN;
-  const gridOffsetY = 0;
+  // Assigning width/height clears the canvas, so only do it on change
+  if (canvas.width !== canvasWidth || canvas.height !== canvasHeight) {
+    canvas.width = canvasWidth;
+    canvas.height = canvasHeight;
+  }
+}
 
-  // Clear
-  ctx.fillStyle = getComputedStyle(document.body).getPropertyValue('--cell-bg') || '#1e1e1e';
-  ctx.fillRect(0, 0, canvas.width, canvas.height);
+/**
+ * Space the container offers to the canvas (minus the canvas border).
+ */
+function availableSize() {
+  const container = canvas.parentElement;
+  const minSize = AXIS_MARGIN + WALL_WIDTH * 2 + MIN_CELL_SIZE;
+  return {
+    width: Math.max(minSize, container.clientWidth - CANVAS_BORDER * 2),
+    height: Math.max(minSize, container.clientHeight - CANVAS_BORDER * 2),
+  };
+}
 
-  // Draw axis labels
-  ctx.fillStyle = getComputedStyle(document.body).getPropertyValue('--fg-color') || '#ccc';
-  ctx.font = 'bold 11px sans-serif';
-  ctx.textAlign = 'center';
-  ctx.textBaseline = 'middle';
+/**
+ * Pick a zoom that shows the whole map if possible, without going past the default size.
+ */
+function fitCamera() {
+  const { width, height } = world.dimensions;
+  const available = availableSize();
+  const fit = Math.min(
+    (Math.min(available.width, MAX_CANVAS_SIZE) - AXIS_MARGIN - WALL_WIDTH * 2) / width,
+    (Math.min(available.height, MAX_CANVAS_SIZE) - AXIS_MARGIN - WALL_WIDTH * 2) / height
+  );
+  camera.cellSize = clampCellSize(Math.min(CELL_SIZE, fit));
+  camera.x = 0;
+  camera.y = 0;
+}
 
-  // X-axis labels (bottom) - centered under each cell
-  for (let x = 1; x <= width; x++) {
-    const labelX = gridOffsetX + WALL_WIDTH + (x - 0.5) * CELL_SIZE;
-    const labelY = canvas.height - AXIS_MARGIN / 2;
-    ctx.fillText(x.toString(), labelX, labelY);
+function clampCellSize(size) {
+  return Math.min(MAX_CELL_SIZE, Math.max(MIN_CELL_SIZE, size));
+}
+
+/**
+ * Keep the camera inside the world.
+ */
+function clampCamera() {
+  const { width, height } = world.dimensions;
+  const { viewWidth, viewHeight } = viewSize();
+  const maxX = Math.max(0, width - viewWidth / camera.cellSize);
+  const maxY = Math.max(0, height - viewHeight / camera.cellSize);
+  camera.x = Math.min(maxX, Math.max(0, camera.x));
+  camera.y = Math.min(maxY, Math.max(0, camera.y));
+}
+
+/**
+ * Range of cells that intersect the grid area, clamped to the world.
+ */
+function visibleRange() {
+  const { width, height } = world.dimensions;
+  const { viewWidth, viewHeight } = viewSize();
+  const cs = camera.cellSize;
+  return {
+    minX: Math.max(1, Math.floor(camera.x) + 1),
+    maxX: Math.min(width, Math.ceil(camera.x + viewWidth / cs)),
+    minY: Math.max(1, Math.floor(camera.y) + 1),
+    maxY: Math.min(height, Math.ceil(camera.y + viewHeight / cs)),
+  };
+}
+
+/**
+ * Canvas x of a vertical grid line (0 is the left edge of the world).
+ * Rounded so cells repainted from the static layer line up exactly.
+ */
+function screenX(gridX) {
+  return Math.round(AXIS_MARGIN + WALL_WIDTH + (gridX - camera.x) * camera.cellSize);
+}
+
+/**
+ * Canvas y of a horizontal grid line (0 is the bottom edge of the world).
+ */
+function screenY(gridY) {
+  const { viewHeight } = viewSize();
+  return Math.round(WALL_WIDTH + viewHeight - (gridY - camera.y) * camera.cellSize);
+}
+
+/**
+ * Canvas rectangle covered by a cell.
+ */
+function cellRect(x, y) {
+  const left = screenX(x - 1);
+  const top = screenY(y);
+  return { left, top, size: screenX(x) - left };
+}
+
+/**
+ * Restrict drawing to the grid area so partially visible cells do not spill
+ * over the axis labels.
+ */
+function clipToGrid() {
+  const { viewWidth, viewHeight } = viewSize();
+  ctx.beginPath();
+  ctx.rect(AXIS_MARGIN + WALL_WIDTH, WALL_WIDTH, viewWidth, viewHeight);
+  ctx.clip();
+}
+
+/**
+ * Recenter the camera on Karel when he gets close to the edge of the view.
+ * Returns true if the camera moved.
+ */
+function followKarel() {
+  const { viewWidth, viewHeight } = viewSize();
+  const cellsX = viewWidth / camera.cellSize;
+  const cellsY = viewHeight / camera.cellSize;
+  const marginX = Math.min(FOLLOW_MARGIN, Math.floor(cellsX / 4));
+  const marginY = Math.min(FOLLOW_MARGIN, Math.floor(cellsY / 4));
+  const { x, y } = world.karel;
+  const oldX = camera.x;
+  const oldY = camera.y;
+
+  if (x - 1 < camera.x + marginX || x > camera.x + cellsX - marginX) {
+    camera.x = x - 0.5 - cellsX / 2;
+  }
+  if (y - 1 < camera.y + marginY || y > camera.y + cellsY - marginY) {
+    camera.y = y - 0.5 - cellsY / 2;
   }
+  clampCamera();
+  return camera.x !== oldX || camera.y !== oldY;
+}
 
-  // Y-axis labels (left) - centered next to each row
-  for (let y = 1; y <= height; y++) {
-    const labelX = AXIS_MARGIN / 2;
-    const labelY = gridOffsetY + WALL_WIDTH + (height - y + 0.5) * CELL_SIZE;
-    ctx.fillText(y.toString(), labelX, labelY);
+/**
+ * Group walls by the lower row they touch so only visible rows are scanned.
+ */
+function indexWalls() {
+  wallsVersion++;
+  wallsByRow = new Map();
+  for (const wall of world.walls) {
+    const row = Math.min(wall.from.y, wall.to.y);
+    let walls = wallsByRow.get(row);
+    if (!walls) {
+      walls = [];
+      wallsByRow.set(row, walls);
+    }
+    walls.push(wall);
+  }
+}
+
+/**
+ * Spacing between axis labels so they never overlap at low zoom.
+ */
+function labelStep(cellSize) {
+  for (let step = 1; ; step *= 10) {
+    if (step * cellSize >= MIN_LABEL_SPACING) return step;
+    if (step * 2 * cellSize >= MIN_LABEL_SPACING) return step * 2;
+    if (step * 5 * cellSize >= MIN_LABEL_SPACING) return step * 5;
   }
+}
 
-  // Draw grid
-  ctx.strokeStyle = '#333';
-  ctx.lineWidth = 1;
+// Pan with drag, zoom with the wheel around the pointer
+canvas.addEventListener('mousedown', (e) => {
+  if (!world || e.button !== 0) return;
+  drag = { startX: e.clientX, startY: e.clientY, cameraX: camera.x, cameraY: camera.y };
+  canvas.classList.add('dragging');
+});
 
-  for (let x = 0; x <= width; x++) {
-    ctx.beginPath();
-    ctx.moveTo(gridOffsetX + WALL_WIDTH + x * CELL_SIZE, gridOffsetY + WALL_WIDTH);
-    ctx.lineTo(gridOffsetX + WALL_WIDTH + x * CELL_SIZE, gridOffsetY + WALL_WIDTH + height * CELL_SIZE);
-    ctx.stroke();
+window.addEventListener('mousemove', (e) => {
+  if (!drag) return;
+  const dx = e.clientX - drag.startX;
+  const dy = e.clientY - drag.startY;
+  if (followCheckbox.checked && (dx !== 0 || dy !== 0)) {
+    // Manual panning takes over from the follow camera
+    followCheckbox.checked = false;
   }
+  camera.x = drag.cameraX - dx / camera.cellSize;
+  camera.y = drag.cameraY + dy / camera.cellSize;
+  scheduleRender();
+});
+
+window.addEventListener('mouseup', () => {
+  drag = null;
+  canvas.classList.remove('dragging');
+});
+
+canvas.addEventListener(
+  'wheel',
+  (e) => {
+    if (!world) return;
+    e.preventDefault();
+
+    const bounds = canvas.getBoundingClientRect();
+    const px = e.clientX - bounds.left - CANVAS_BORDER - AXIS_MARGIN - WALL_WIDTH;
+    const py = e.clientY - bounds.top - CANVAS_BORDER - WALL_WIDTH;
+    const { viewHeight } = viewSize();
+
+    // World point under the pointer stays fixed while zooming
+    const worldX = camera.x + px / camera.cellSize;
+    const worldY = camera.y + (viewHeight - py) / camera.cellSize;
+    const factor = e.deltaY < 0 ? ZOOM_FACTOR : 1 / ZOOM_FACTOR;
+    camera.cellSize = clampCellSize(camera.cellSize * factor);
+
+    resizeCanvas();
+    const resized = viewSize();
+    camera.x = worldX - px / camera.cellSize;
+    camera.y = worldY - (resized.viewHeight - py) / camera.cellSize;
+    scheduleRender();
+  },
+  { passive: false }
+);
+
+window.addEventListener('resize', () => {
+  if (world) scheduleRender();
+});
+
+/**
+ * Draw everything that only changes when the map or the camera changes into an
+ * offscreen canvas the size of the viewport: background, axis labels, grid
+ * lines, walls and border. Only the visible range is drawn.
+ */
+function buildStaticLayer() {
+  const { width, height } = world.dimensions;
+  const { viewWidth, viewHeight } = viewSize();
+  const range = visibleRange();
+  const cs = camera.cellSize;
 
-  for (let y = 0; y <= height; y++) {
-    ctx.beginPath();
-    ctx.moveTo(gridOffsetX + WALL_WIDTH, gridOffsetY + WALL_WIDTH + y * CELL_SIZE);
-    ctx.lineTo(gridOffsetX + WALL_WIDTH + width * CELL_SIZE, gridOffsetY + WALL_WIDTH + y * CELL_SIZE);
-    ctx.stroke();
+  if (!staticLayer) {
+    staticLayer = document.createElement('canvas');
   }
+  staticLayer.width = canvas.width;
+  staticLayer.height = canvas.height;
 
-  // Draw beepers
-  ctx.fillStyle = '#f0c040';
-  for (const beeper of world.beepers) {
-    const cx = gridOffsetX + WALL_WIDTH + (beeper.x - 0.5) * CELL_SIZE;
-    const cy = gridOffsetY + WALL_WIDTH + (height - beeper.y + 0.5) * CELL_SIZE;
-
-    ctx.beginPath();
-    ctx.arc(cx, cy, CELL_SIZE / 4, 0, Math.PI * 2);
-    ctx.fill();
-
-    // Show count if > 1
-    if (beeper.count > 1) {
-      ctx.fillStyle = '#000';
-      ctx.font = '12px sans-serif';
-      ctx.textAlign = 'center';
-      ctx.textBaseline = 'middle';
-      ctx.fillText(beeper.count.toString(), cx, cy);
-      ctx.fillStyle = '#f0c040';
+  const layer = staticLayer.getContext('2d');
+  const style = getComputedStyle(document.body);
+
+  // Clear
+  layer.fillStyle = style.getPropertyValue('--cell-bg') || '#1e1e1e';
+  layer.fillRect(0, 0, staticLayer.width, staticLayer.height);
+
+  // Draw axis labels, thinned out and shrunk as the zoom goes down
+  const step = labelStep(cs);
+  layer.fillStyle = style.getPropertyValue('--fg-color') || '#ccc';
+  layer.font = 'bold ' + Math.round(Math.min(11, Math.max(8, cs * 0.3))) + 'px sans-serif';
+  layer.textAlign = 'center';
+  layer.textBaseline = 'middle';
+
+  // X-axis labels (bottom) - centered under each cell
+  const labelsTop = WALL_WIDTH * 2 + viewHeight;
+  for (let x = range.minX; x <= range.maxX; x++) {
+    if (x % step !== 0) continue;
+    const cx = (screenX(x - 1) + screenX(x)) / 2;
+    if (cx >= AXIS_MARGIN + WALL_WIDTH && cx <= AXIS_MARGIN + WALL_WIDTH + viewWidth) {
+      layer.fillText(x.toString(), cx, labelsTop + AXIS_MARGIN / 2);
     }
   }
 
-  // Draw walls
-  ctx.strokeStyle = '#888';
-  ctx.lineWidth = WALL_WIDTH;
-  ctx.lineCap = 'round';
+  // Y-axis labels (left) - centered next to each row
+  for (let y = range.minY; y <= range.maxY; y++) {
+    if (y % step !== 0) continue;
+    const cy = (screenY(y) + screenY(y - 1)) / 2;
+    if (cy >= WALL_WIDTH && cy <= WALL_WIDTH + viewHeight) {
+      layer.fillText(y.toString(), AXIS_MARGIN / 2, cy);
+    }
+  }
 
-  for (const wall of world.walls) {
-    const { from, to } = wall;
-
-    // Wall is drawn on the shared edge between from and to cells
-    // Calculate the grid line position where the wall should be drawn
-    ctx.beginPath();
-    if (from.x === to.x) {
-      // Cells are vertically adjacent (same x, different y)
-      // Wall is horizontal, drawn between the two cells
-      const wallY = Math.max(from.y, to.y); // The y coordinate of the upper cell
-      const screenX = gridOffsetX + WALL_WIDTH + (from.x - 1) * CELL_SIZE;
-      const screenY = gridOffsetY + WALL_WIDTH + (height - wallY + 1) * CELL_SIZE;
-      ctx.moveTo(screenX, screenY);
-      ctx.lineTo(screenX + CELL_SIZE, screenY);
-    } else {
-      // Cells are horizontally adjacent (same y, different x)
-      // Wall is vertical, drawn between the two cells
-      const wallX = Math.max(from.x, to.x); // The x coordinate of the right cell
-      const screenX = gridOffsetX + WALL_WIDTH + (wallX - 1) * CELL_SIZE;
-      const screenY = gridOffsetY + WALL_WIDTH + (height - from.y) * CELL_SIZE;
-      ctx.moveTo(screenX, screenY);
-      ctx.lineTo(screenX, screenY + CELL_SIZE);
+  // Everything below stays inside the grid area plus its border
+  layer.save();
+  layer.beginPath();
+  layer.rect(AXIS_MARGIN, 0, viewWidth + WALL_WIDTH * 2, viewHeight + WALL_WIDTH * 2);
+  layer.clip();
+
+  const left = screenX(range.minX - 1);
+  const right = screenX(range.maxX);
+  const top = screenY(range.maxY);
+  const bottom = screenY(range.minY - 1);
+
+  // Draw grid as a single path (skipped when cells are too small to see lines)
+  if (cs >= MIN_GRID_CELL_SIZE) {
+    layer.strokeStyle = '#333';
+    layer.lineWidth = 1;
+    layer.beginPath();
+    for (let x = range.minX - 1; x <= range.maxX; x++) {
+      layer.moveTo(screenX(x), top);
+      layer.lineTo(screenX(x), bottom);
     }
-    ctx.stroke();
+    for (let y = range.minY - 1; y <= range.maxY; y++) {
+      layer.moveTo(left, screenY(y));
+      layer.lineTo(right, screenY(y));
+    }
+    layer.stroke();
   }
 
-  // Draw border walls
-  ctx.strokeStyle = '#666';
-  ctx.lineWidth = WALL_WIDTH;
-  ctx.strokeRect(
-    gridOffsetX + WALL_WIDTH / 2,
-    gridOffsetY + WALL_WIDTH / 2,
-    width * CELL_SIZE + WALL_WIDTH,
-    height * CELL_SIZE + WALL_WIDTH
+  // Draw walls in the visible rows as a single path
+  layer.strokeStyle = '#888';
+  layer.lineWidth = Math.min(WALL_WIDTH, Math.max(1, cs / 8));
+  layer.lineCap = 'round';
+  layer.beginPath();
+  for (let row = range.minY - 1; row <= range.maxY; row++) {
+    const walls = wallsByRow.get(row);
+    if (!walls) continue;
+
+    for (const wall of walls) {
+      const { from, to } = wall;
+
+      // Wall is drawn on the shared edge between from and to cells
+      if (from.x === to.x) {
+        // Cells are vertically adjacent: horizontal wall below the upper cell
+        if (from.x < range.minX || from.x > range.maxX) continue;
+        const wallY = screenY(row);
+        layer.moveTo(screenX(from.x - 1), wallY);
+        layer.lineTo(screenX(from.x), wallY);
+      } else {
+        // Cells are horizontally adjacent: vertical wall left of the right cell
+        if (row < range.minY) continue;
+        const wallX = Math.max(from.x, to.x);
+        if (wallX - 1 < range.minX - 1 || wallX - 1 > range.maxX) continue;
+        const screenWallX = screenX(wallX - 1);
+        layer.moveTo(screenWallX, screenY(row));
+        layer.lineTo(screenWallX, screenY(row - 1));
+      }
+    }
+  }
+  layer.stroke();
+
+  // Draw border walls (only the sides that are in view end up visible)
+  layer.strokeStyle = '#666';
+  layer.lineWidth = WALL_WIDTH;
+  layer.strokeRect(
+    screenX(0) - WALL_WIDTH / 2,
+    screenY(height) - WALL_WIDTH / 2,
+    screenX(width) - screenX(0) + WALL_WIDTH,
+    screenY(0) - screenY(height) + WALL_WIDTH
   );
+  layer.restore();
+}
+
+function drawBeeper(x, y, count) {
+  const { left, top, size } = cellRect(x, y);
+  const cx = left + size / 2;
+  const cy = top + size / 2;
 
-  // Draw Karel
-  drawKarel(world.karel, height, gridOffsetX, gridOffsetY);
+  ctx.fillStyle = '#f0c040';
+  ctx.beginPath();
+  ctx.arc(cx, cy, Math.max(1, size / 4), 0, Math.PI * 2);
+  ctx.fill();
+
+  // Show count if > 1 and there is room for it
+  if (count > 1 && size >= 16) {
+    ctx.fillStyle = '#000';
+    ctx.font = Math.round(Math.min(12, size * 0.3)) + 'px sans-serif';
+    ctx.textAlign = 'center';
+    ctx.textBaseline = 'middle';
+    ctx.fillText(count.toString(), cx, cy);
+  }
 }
 
-function drawKarel(karel, worldHeight, gridOffsetX, gridOffsetY) {
-  const cx = gridOffsetX + WALL_WIDTH + (karel.x - 0.5) * CELL_SIZE;
-  const cy = gridOffsetY + WALL_WIDTH + (worldHeight - karel.y + 0.5) * CELL_SIZE;
-  const size = CELL_SIZE * 0.7;
+function drawKarel(karel) {
+  const cell = cellRect(karel.x, karel.y);
+  const cx = cell.left + cell.size / 2;
+  const cy = cell.top + cell.size / 2;
+  const size = Math.max(3, cell.size * 0.7);
 
   ctx.save();
   ctx.translate(cx, cy);
@@ -239,7 +763,7 @@ function drawKarel(karel, worldHeight, gridOffsetX, gridOffsetY) {
 
   // Draw outline
   ctx.strokeStyle = '#2060d0';
-  ctx.lineWidth = 2;
+  ctx.lineWidth = Math.min(2, Math.max(1, cell.size / 20));
   ctx.stroke();
 
   ctx.restore();
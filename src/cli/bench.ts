@@ -0,0 +1,128 @@
+/**
+ * Step loop benchmark for the command-line runner (--bench).
+ *
+ * Runs a program over and over on one world until a million steps have
+ * executed, and checks that the interpreter's steady state allocates
+ * nothing: no scavenge may run during the measured steps, and the heap in
+ * use must not grow across them. The heap is sampled without forcing a
+ * collection in between, so short-lived garbage counts too.
+ */
+
+import * as v8 from "v8";
+import * as vm from "vm";
+import { PerformanceObserver, constants } from "perf_hooks";
+import { World, KarelMap } from "@/interpreter/world";
+import { Interpreter } from "@/interpreter/execution/interpreter";
+import { RuntimeError } from "@/interpreter/types/errors";
+
+/**
+ * Steps measured, after one warm-up run.
+ */
+const BENCH_STEPS = 1_000_000;
+
+/**
+ * Heap growth per million steps still treated as allocation-free (room for
+ * JIT and inline cache bookkeeping).
+ */
+const MAX_HEAP_GROWTH = 64 * 1024;
+
+export interface BenchResult {
+  /** Steps measured (whole runs, so at least a million). */
+  steps: number;
+  /** Runs of the program the steps were spread over. */
+  runs: number;
+  timeMs: number;
+  stepsPerSecond: number;
+  /** Heap in use grown over the measured runs, in bytes per million steps. */
+  heapGrowthPerMillion: number;
+  /** Garbage collections while the measured runs executed. */
+  gcCount: number;
+  /** Of those, minor collections (scavenges) of the young generation. */
+  scavengeCount: number;
+  /** Whether no scavenge ran and the heap growth stayed under the allowed limit. */
+  passed: boolean;
+}
+
+/**
+ * Get a function that forces a full garbage collection, without needing
+ * node to be started with --expose-gc.
+ */
+function exposeGc(): () => void {
+  v8.setFlagsFromString("--expose-gc");
+  return vm.runInNewContext("gc") as () => void;
+}
+
+/**
+ * Benchmark a program on a map. Throws if the program does not parse or
+ * executes no steps.
+ */
+export async function runBenchmark(source: string, map: KarelMap): Promise<BenchResult> {
+  const world = World.fromJSON(map);
+  const interpreter = new Interpreter(world);
+  interpreter.setTier("vm"); // measure the VM's step loop
+  const errors = interpreter.load(source).filter((d) => d.severity === "error");
+  if (errors.length > 0) {
+    throw new Error(errors[0].message);
+  }
+
+  // Runs that end in a runtime error still count: only the loop is measured
+  const runOnce = (): number => {
+    interpreter.reset();
+    try {
+      interpreter.runHeadless();
+    } catch (e) {
+      if (!(e instanceof RuntimeError)) {
+        throw e;
+      }
+    }
+    return interpreter.getStepCount();
+  };
+
+  if (runOnce() === 0) {
+    throw new Error("The program executes no steps");
+  }
+
+  const gc = exposeGc();
+  let gcCount = 0;
+  let scavengeCount = 0;
+  const observer = new PerformanceObserver((list) => {
+    for (const entry of list.getEntries()) {
+      const detail = entry.detail as { kind?: number } | undefined;
+      gcCount++;
+      if (detail?.kind === constants.NODE_PERFORMANCE_GC_MINOR) {
+        scavengeCount++;
+      }
+    }
+  });
+
+  gc();
+  const heapBefore = process.memoryUsage().heapUsed;
+  observer.observe({ entryTypes: ["gc"] });
+
+  const start = performance.now();
+  let steps = 0;
+  let runs = 0;
+  while (steps < BENCH_STEPS) {
+    steps += runOnce();
+    runs++;
+  }
+  const timeMs = performance.now() - start;
+  // No forced collection first: garbage the runs left behind counts as growth
+  const heapGrowth = Math.max(0, process.memoryUsage().heapUsed - heapBefore);
+
+  // GC entries are delivered on a timer; wait one so the observer sees them all
+  await new Promise((resolve) => setTimeout(resolve, 0));
+  observer.disconnect();
+  const heapGrowthPerMillion = Math.round((heapGrowth * 1_000_000) / steps);
+
+  return {
+    steps,
+    runs,
+    timeMs,
+    stepsPerSecond: Math.round((steps * 1000) / timeMs),
+    heapGrowthPerMillion,
+    gcCount,
+    scavengeCount,
+    passed: scavengeCount === 0 && heapGrowthPerMillion <= MAX_HEAP_GROWTH,
+  };
+}
@@ -0,0 +1,313 @@
+/**
+ * Command-line runner for Karel programs.
+ *
+ * Runs programs headless and at full speed, without VS Code.
+ * Built as a separate webpack entry (dist/cli.js).
+ *
+ * Usage:
+ *   node dist/cli.js <program.kli> <world.klm> [--compact] [--trace out.kltrace]
+ *                    [--tier vm|js|wasm] [--max-steps N] [--max-control N]
+ *   node dist/cli.js --batch <program.kli> <folder|glob|map.klm>... [--workers N] [--json]
+ *                    [--lockstep] [--max-steps N] [--max-control N]
+ *   node dist/cli.js --bench <program.kli> <world.klm>
+ *   node dist/cli.js --verify <program.kli> <world.klm> [--max-steps N] [--max-control N]
+ *
+ * Single runs print a JSON report (status, steps, timeMs, world, error) to stdout,
+ * and with --trace also save an execution trace for replay in the visualizer.
+ * --tier picks the engine (js by default; wasm is experimental).
+ * --max-steps and --max-control set the budget of each run (primitives and
+ * calls, and control instructions); a run that uses it up reports "paused".
+ * Batch runs print a summary table (or the results as JSON with --json).
+ * With --lockstep, batch runs stay in-process and maps that share dimensions
+ * and walls run together on the lockstep engine.
+ * Bench runs repeat a program for a million steps and report speed and heap
+ * growth; they fail if the step loop allocates (any scavenge, or heap growth).
+ * Verify runs execute a program on every tier and fail if any of them disagrees
+ * with the VM.
+ * Exit codes: 0 completed (every map passed), 1 runtime error or paused (a map
+ * failed), 2 invalid program or bad input.
+ */
+
+import * as fs from "fs";
+import * as path from "path";
+import { KarelMap } from "@/interpreter/world";
+import { Parser } from "@/interpreter/parsing/parser";
+import { runHeadless, HeadlessResult } from "@/interpreter/execution/headless";
+import { ExecutionTier } from "@/interpreter/execution/interpreter";
+import { ExecutionBudget } from "@/interpreter/execution/budget";
+import { runBatch, formatBatchSummary } from "@/interpreter/batch/batchRunner";
+import { findMapFiles } from "@/interpreter/batch/mapFiles";
+import { runLockstepBatch } from "@/interpreter/batch/lockstepBatch";
+import { runBenchmark } from "@/cli/bench";
+import { verifyTiers } from "@/cli/verify";
+
+const USAGE = [
+  "Usage: karel <program.kli> <world.klm> [--compact] [--trace out.kltrace] [--tier vm|js|wasm]",
+  "             [--max-steps N] [--max-control N]",
+  "       karel --batch <program.kli> <folder|glob|map.klm>... [--workers N] [--json] [--lockstep]",
+  "             [--max-steps N] [--max-control N]",
+  "       karel --bench <program.kli> <world.klm>",
+  "       karel --verify <program.kli> <world.klm> [--max-steps N] [--max-control N]",
+].join("\n");
+
+/**
+ * Process exit codes.
+ */
+export enum ExitCode {
+  Completed = 0,
+  RuntimeError = 1,
+  InvalidInput = 2,
+}
+
+/**
+ * Parsed command line: positional arguments plus --flags (with optional values).
+ */
+interface CliArgs {
+  files: string[];
+  flags: Map<string, string | true>;
+}
+
+/**
+ * Flags that take a value.
+ */
+const VALUE_FLAGS = new Set(["--workers", "--trace", "--tier", "--max-steps", "--max-control"]);
+
+const TIERS: ExecutionTier[] = ["vm", "js", "wasm"];
+
+function parseArgs(argv: string[]): CliArgs {
+  const files: string[] = [];
+  const flags = new Map<string, string | true>();
+  for (let i = 0; i < argv.length; i++) {
+    const arg = argv[i];
+    if (!arg.startsWith("--")) {
+      files.push(arg);
+    } else if (VALUE_FLAGS.has(arg) && i + 1 < argv.length) {
+      flags.set(arg, argv[++i]);
+    } else {
+      flags.set(arg, true);
+    }
+  }
+  return { files, flags };
+}
+
+/**
+ * Budget from --max-steps and --max-control (defaults for those not given),
+ * or null if a value is not a positive integer.
+ */
+function parseBudget(args: CliArgs): Partial<ExecutionBudget> | null {
+  const budget: Partial<ExecutionBudget> = {};
+  const flags: [string, keyof ExecutionBudget][] = [
+    ["--max-steps", "steps"],
+    ["--max-control", "control"],
+  ];
+  for (const [flag, kind] of flags) {
+    const value = args.flags.get(flag);
+    if (value === undefined) {
+      continue;
+    }
+    const limit = typeof value === "string" && /^\d+$/.test(value) ? Number(value) : 0;
+    if (!Number.isSafeInteger(limit) || limit <= 0) {
+      return null;
+    }
+    budget[kind] = limit;
+  }
+  return budget;
+}
+
+function exitCodeFor(result: HeadlessResult): ExitCode {
+  switch (result.status) {
+    case "completed":
+      return ExitCode.Completed;
+    case "error":
+    case "paused":
+      return ExitCode.RuntimeError;
+    case "invalid":
+      return ExitCode.InvalidInput;
+  }
+}
+
+function readMap(mapPath: string): KarelMap {
+  try {
+    return JSON.parse(fs.readFileSync(mapPath, "utf8")) as KarelMap;
+  } catch (e) {
+    throw new Error(`Invalid map file ${mapPath}: ${(e as Error).message}`);
+  }
+}
+
+/**
+ * Run one program on one map and print the JSON report.
+ */
+function runSingle(args: CliArgs): ExitCode {
+  if (args.files.length !== 2) {
+    console.error(USAGE);
+    return ExitCode.InvalidInput;
+  }
+
+  const [programPath, mapPath] = args.files;
+  const tracePath = args.flags.get("--trace");
+  const tier = args.flags.get("--tier") ?? "js";
+  const budget = parseBudget(args);
+  if (!TIERS.includes(tier as ExecutionTier) || !budget) {
+    console.error(USAGE);
+    return ExitCode.InvalidInput;
+  }
+
+  let result: HeadlessResult;
+  try {
+    const source = fs.readFileSync(programPath, "utf8");
+    result = runHeadless(source, readMap(mapPath), {
+      trace: typeof tracePath === "string",
+      tier: tier as ExecutionTier,
+      budget,
+    });
+    if (typeof tracePath === "string" && result.trace) {
+      fs.writeFileSync(tracePath, result.trace);
+    }
+  } catch (e) {
+    console.error((e as Error).message);
+    return ExitCode.InvalidInput;
+  }
+
+  if (result.status === "invalid") {
+    for (const d of result.diagnostics ?? []) {
+      console.error(`${programPath}:${d.line}:${d.column}: ${d.message}`);
+    }
+  } else if (result.status === "error" || result.status === "paused") {
+    const location = result.error?.line ? `${programPath}:${result.error.line}: ` : "";
+    console.error(`${location}${result.error?.message}`);
+  }
+
+  const report = { ...result, trace: undefined }; // saved separately, not printed
+  console.log(JSON.stringify(report, null, args.flags.has("--compact") ? undefined : 2));
+  return exitCodeFor(result);
+}
+
+/**
+ * Run one program on every matching map using a worker pool (or in-process on
+ * the lockstep engine with --lockstep).
+ */
+async function runBatchMode(args: CliArgs): Promise<ExitCode> {
+  const [programPath, ...patterns] = args.files;
+  const budget = parseBudget(args);
+  if (!programPath || patterns.length === 0 || !budget) {
+    console.error(USAGE);
+    return ExitCode.InvalidInput;
+  }
+
+  let source: string;
+  try {
+    source = fs.readFileSync(programPath, "utf8");
+  } catch (e) {
+    console.error((e as Error).message);
+    return ExitCode.InvalidInput;
+  }
+
+  // Report parse errors once instead of once per map
+  const errors = new Parser().parse(source).diagnostics.filter((d) => d.severity === "error");
+  if (errors.length > 0) {
+    for (const d of errors) {
+      console.error(`${programPath}:${d.line}:${d.column}: ${d.message}`);
+    }
+    return ExitCode.InvalidInput;
+  }
+
+  const mapPaths = [...new Set(patterns.flatMap(findMapFiles))];
+  if (mapPaths.length === 0) {
+    console.error(`No .klm files match ${patterns.join(" ")}`);
+    return ExitCode.InvalidInput;
+  }
+
+  const workers = args.flags.get("--workers");
+  const start = performance.now();
+  const results = args.flags.has("--lockstep")
+    ? runLockstepBatch(source, mapPaths, budget)
+    : await runBatch(source, mapPaths, {
+        // The pool worker is bundled next to this script
+        scriptPath: path.join(path.dirname(fs.realpathSync(process.argv[1])), "batchWorker.js"),
+        workers: typeof workers === "string" ? parseInt(workers, 10) || undefined : undefined,
+        budget,
+      });
+  const elapsed = performance.now() - start;
+
+  if (args.flags.has("--json")) {
+    console.log(JSON.stringify({ results, timeMs: elapsed }, null, 2));
+  } else {
+    console.log(formatBatchSummary(results, elapsed));
+  }
+
+  return results.every((r) => r.passed) ? ExitCode.Completed : ExitCode.RuntimeError;
+}
+
+/**
+ * Benchmark the step loop on one program and map, and print the JSON report.
+ */
+async function runBenchMode(args: CliArgs): Promise<ExitCode> {
+  if (args.files.length !== 2) {
+    console.error(USAGE);
+    return ExitCode.InvalidInput;
+  }
+
+  const [programPath, mapPath] = args.files;
+  try {
+    const source = fs.readFileSync(programPath, "utf8");
+    const result = await runBenchmark(source, readMap(mapPath));
+    console.log(JSON.stringify(result, null, 2));
+    return result.passed ? ExitCode.Completed : ExitCode.RuntimeError;
+  } catch (e) {
+    console.error((e as Error).message);
+    return ExitCode.InvalidInput;
+  }
+}
+
+/**
+ * Run one program and map on every tier, and print the JSON report.
+ */
+function runVerifyMode(args: CliArgs): ExitCode {
+  if (args.files.length !== 2) {
+    console.error(USAGE);
+    return ExitCode.InvalidInput;
+  }
+
+  const [programPath, mapPath] = args.files;
+  const budget = parseBudget(args);
+  if (!budget) {
+    console.error(USAGE);
+    return ExitCode.InvalidInput;
+  }
+  try {
+    const source = fs.readFileSync(programPath, "utf8");
+    const result = verifyTiers(source, readMap(mapPath), budget);
+    if (result.diagnostics) {
+      for (const d of result.diagnostics) {
+        console.error(`${programPath}:${d.line}:${d.column}: ${d.message}`);
+      }
+      return ExitCode.InvalidInput;
+    }
+    console.log(JSON.stringify(result, null, 2));
+    return result.passed ? ExitCode.Completed : ExitCode.RuntimeError;
+  } catch (e) {
+    console.error((e as Error).message);
+    return ExitCode.InvalidInput;
+  }
+}
+
+async function main(argv: string[]): Promise<ExitCode> {
+  const args = parseArgs(argv);
+  if (args.flags.has("--bench")) {
+    return runBenchMode(args);
+  }
+  if (args.flags.has("--verify")) {
+    return runVerifyMode(args);
+  }
+  return args.flags.has("--batch") ? runBatchMode(args) : runSingle(args);
+}
+
+main(process.argv.slice(2)).then(
+  (code) => {
+    process.exitCode = code;
+  },
+  (error) => {
+    console.error(error instanceof Error ? error.message : error);
+    process.exitCode = ExitCode.InvalidInput;
+  }
+);
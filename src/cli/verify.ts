@@ -0,0 +1,72 @@
+/**
+ * Differential check of the execution tiers for the command-line runner (--verify).
+ *
+ * Runs a program on one map on the VM, the JavaScript tier and the
+ * WebAssembly tier, and compares what each reports: status, steps, runtime
+ * error and final world. The compiled tiers must match the VM exactly, so
+ * any difference is a bug in one of them.
+ */
+
+import { KarelMap } from "@/interpreter/world";
+import { runHeadless, HeadlessResult, HeadlessStatus } from "@/interpreter/execution/headless";
+import { ExecutionTier } from "@/interpreter/execution/interpreter";
+import { Diagnostic } from "@/interpreter/types/errors";
+import { ExecutionBudget } from "@/interpreter/execution/budget";
+
+/**
+ * Tiers compared; the first one is the reference.
+ */
+const TIERS: ExecutionTier[] = ["vm", "js", "wasm"];
+
+export interface TierRun {
+  /** Tier requested. */
+  tier: ExecutionTier;
+  /** Engine that finished the run ("vm" when the tier fell back to it). */
+  executedBy: ExecutionTier;
+  status: HeadlessStatus;
+  steps: number;
+  timeMs: number;
+  error?: { message: string; line?: number };
+  /** Whether status, steps, error and final world match the VM's. */
+  matches: boolean;
+}
+
+export interface VerifyResult {
+  runs: TierRun[];
+  passed: boolean;
+  /** Parser errors, when the program did not parse (nothing was compared). */
+  diagnostics?: Diagnostic[];
+}
+
+/**
+ * Everything a run reports that must not depend on the tier.
+ */
+function outcome(result: HeadlessResult): string {
+  return JSON.stringify([result.status, result.steps, result.error, result.world]);
+}
+
+/**
+ * Run a program on a map on every tier and compare the results.
+ */
+export function verifyTiers(
+  source: string,
+  map: KarelMap,
+  budget: Partial<ExecutionBudget> = {}
+): VerifyResult {
+  const results = TIERS.map((tier) => runHeadless(source, map, { tier, budget }));
+  const reference = outcome(results[0]);
+  if (results[0].status === "invalid") {
+    return { runs: [], passed: false, diagnostics: results[0].diagnostics };
+  }
+
+  const runs = results.map((result, i) => ({
+    tier: TIERS[i],
+    executedBy: result.tier,
+    status: result.status,
+    steps: result.steps,
+    timeMs: result.timeMs,
+    error: result.error,
+    matches: outcome(result) === reference,
+  }));
+  return { runs, passed: runs.every((run) => run.matches) };
+}
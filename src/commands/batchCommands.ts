@@ -0,0 +1,75 @@
+/**
+ * Batch Commands
+ * Runs one program against a folder of maps on a worker pool
+ */
+
+import * as vscode from "vscode";
+import { StateManager, FileService, ExecutionService } from "@/services";
+import { UIMessages } from "@/i18n/messages";
+import { runBatch, formatBatchSummary } from "@/interpreter/batch/batchRunner";
+import { findMapFiles } from "@/interpreter/batch/mapFiles";
+
+/**
+ * Use the active Karel instructions file, or prompt for one.
+ */
+async function getProgramDocument(): Promise<vscode.TextDocument | undefined> {
+  const editor = vscode.window.activeTextEditor;
+  if (editor && editor.document.languageId === "karel-instructions") {
+    return editor.document;
+  }
+
+  const fileService = FileService.getInstance();
+  const uri = await fileService.selectProgramFile();
+  return uri ? fileService.openFile(uri) : undefined;
+}
+
+/**
+ * Run the active (or a selected) program on every .klm file in a folder and
+ * write a summary table to the output channel.
+ */
+export async function runBatchCommand(context: vscode.ExtensionContext): Promise<void> {
+  const state = StateManager.getInstance();
+  const fileService = FileService.getInstance();
+
+  const document = await getProgramDocument();
+  if (!document) {
+    return;
+  }
+
+  const folder = await fileService.selectMapFolder();
+  if (!folder) {
+    return;
+  }
+
+  const mapPaths = findMapFiles(folder.fsPath);
+  if (mapPaths.length === 0) {
+    vscode.window.showWarningMessage(UIMessages.noMapsFound(folder.fsPath));
+    return;
+  }
+
+  const source = document.getText();
+  const scriptPath = vscode.Uri.joinPath(context.extensionUri, "dist", "batchWorker.js").fsPath;
+
+  await vscode.window.withProgress(
+    {
+      location: vscode.ProgressLocation.Notification,
+      title: UIMessages.batchRunning(mapPaths.length),
+    },
+    async (progress) => {
+      const start = performance.now();
+      const results = await runBatch(source, mapPaths, {
+        scriptPath,
+        budget: ExecutionService.configuredBudget(),
+        onResult: () => progress.report({ increment: 100 / mapPaths.length }),
+      });
+      const elapsed = performance.now() - start;
+
+      state.outputChannel.appendLine(fileService.getWorkspaceRelativePath(document.uri));
+      state.outputChannel.appendLine(formatBatchSummary(results, elapsed, folder.fsPath));
+      state.outputChannel.show(true);
+
+      const passed = results.filter((r) => r.passed).length;
+      vscode.window.showInformationMessage(UIMessages.batchCompleted(passed, results.length));
+    }
+  );
+}
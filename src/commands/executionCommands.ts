@@ -4,30 +4,49 @@
  */
 
 import * as vscode from "vscode";
-import { World, Interpreter, RuntimeError } from "@/interpreter";
+import {
+  World,
+  Interpreter,
+  RuntimeError,
+  TracePlayer,
+  runHeadless,
+  DEFAULT_MAX_RECURSION_DEPTH,
+} from "@/interpreter";
 import { WebviewProvider } from "@/providers";
-import { StateManager, FileService } from "@/services";
+import { StateManager, FileService, ExecutionService } from "@/services";
 import { clearExecutionHighlight } from "@/ui";
 import { UIMessages } from "@/i18n/messages";
+import { playTrace } from "./traceCommands";
 
 // Re-export for backwards compatibility (used in worldCommands)
 export { clearExecutionHighlight };
 
+/**
+ * Callback surface shared by the Interpreter and ExecutionService, plus what
+ * continuing a paused run needs.
+ */
+type ExecutionCallbacks = Pick<
+  Interpreter,
+  "onStep" | "onSlice" | "onComplete" | "onError" | "onBudgetExhausted" | "extendBudget" | "run"
+>;
+
 /**
  * Set up interpreter callbacks for execution.
  * @param webview - The webview provider to update
  * @param includeEditorHighlight - Whether to highlight current line in editor (for step mode)
+ * @param target - Where to install the callbacks (defaults to the in-process interpreter)
  */
 function setupInterpreterCallbacks(
   webview: WebviewProvider,
-  includeEditorHighlight: boolean = false
+  includeEditorHighlight: boolean = false,
+  target: ExecutionCallbacks | null = StateManager.getInstance().interpreter
 ): void {
   const state = StateManager.getInstance();
-  if (!state.interpreter) {
+  if (!target) {
     return;
   }
 
-  state.interpreter.onStep = (line) => {
+  target.onStep = (line) => {
     webview.updateView();
     webview.highlightLine(line);
 
@@ -43,7 +62,13 @@ function setupInterpreterCallbacks(
     }
   };
 
-  state.interpreter.onComplete = () => {
+  // Turbo mode only reports the latest state at the end of each time slice
+  target.onSlice = (line) => {
+    webview.updateView();
+    webview.highlightLine(line);
+  };
+
+  target.onComplete = () => {
     webview.setStatus("completed", UIMessages.executionCompleted());
     state.outputChannel.appendLine(UIMessages.executionCompleted());
     if (includeEditorHighlight) {
@@ -51,7 +76,7 @@ function setupInterpreterCallbacks(
     }
   };
 
-  state.interpreter.onError = (error: RuntimeError) => {
+  target.onError = (error: RuntimeError) => {
     webview.setStatus("error", error.message);
     state.outputChannel.appendLine(`Error: ${error.message}`);
     vscode.window.showErrorMessage(error.message);
@@ -59,6 +84,34 @@ function setupInterpreterCallbacks(
       clearExecutionHighlight();
     }
   };
+
+  // The run keeps its state when the budget runs out; offer to go on
+  target.onBudgetExhausted = async (message: string) => {
+    webview.setStatus("stopped", message);
+    state.outputChannel.appendLine(message);
+
+    const choice = await vscode.window.showWarningMessage(message, UIMessages.continueOption());
+    const current = target === state.interpreter || target === state.execution;
+    if (choice !== UIMessages.continueOption() || !current) {
+      return;
+    }
+
+    target.extendBudget();
+    if (includeEditorHighlight) {
+      webview.setStatus("stepping", UIMessages.stepMode());
+      return;
+    }
+    webview.setStatus("running", UIMessages.executionContinued());
+    state.outputChannel.appendLine(UIMessages.executionContinued());
+    try {
+      await target.run();
+    } catch (error) {
+      if (error instanceof Error) {
+        webview.setStatus("error", error.message);
+        state.outputChannel.appendLine(`Error: ${error.message}`);
+      }
+    }
+  };
 }
 
 /**
@@ -98,17 +151,33 @@ async function ensureMapFile(context: vscode.ExtensionContext): Promise<boolean>
 /**
  * Initialize interpreter with current world and source.
  * Returns false if there are errors in the code.
+ * @param stepping - Whether the run starts in step mode
  */
-function initializeInterpreter(source: string): boolean {
+function initializeInterpreter(source: string, stepping: boolean = false): boolean {
   const state = StateManager.getInstance();
   if (!state.world) {
     return false;
   }
 
+  // Only one execution backend is active at a time
+  state.execution?.dispose();
+  state.execution = null;
+  state.disposePlayback();
+
   state.interpreter = new Interpreter(state.world);
 
-  const speed = vscode.workspace.getConfiguration("vs-karel").get("executionSpeed", 500);
-  state.interpreter.setSpeed(speed);
+  const config = vscode.workspace.getConfiguration("vs-karel");
+  const turbo = config.get("executionMode", "animated") === "turbo";
+  // Turbo runs skip the checkpoints: stepping back is for watched runs
+  if (stepping || !turbo) {
+    state.interpreter.enableHistory();
+  }
+  state.interpreter.setSpeed(config.get("executionSpeed", 500));
+  state.interpreter.setTurbo(turbo);
+  state.interpreter.setMaxRecursionDepth(
+    config.get("maxRecursionDepth", DEFAULT_MAX_RECURSION_DEPTH)
+  );
+  state.interpreter.setBudget(ExecutionService.configuredBudget());
 
   const diagnostics = state.interpreter.load(source);
   if (diagnostics.some((d) => d.severity === "error")) {
@@ -119,6 +188,117 @@ function initializeInterpreter(source: string): boolean {
   return true;
 }
 
+/**
+ * Check if continuous runs should execute on a worker_thread.
+ */
+function shouldRunInWorker(): boolean {
+  return vscode.workspace.getConfiguration("vs-karel").get("runInWorker", false);
+}
+
+/**
+ * Run the program on a worker_thread through ExecutionService.
+ * The worker's state snapshots are mirrored into state.world.
+ */
+async function runInWorker(
+  context: vscode.ExtensionContext,
+  webview: WebviewProvider,
+  source: string
+): Promise<void> {
+  const state = StateManager.getInstance();
+  if (!state.world) {
+    return;
+  }
+
+  state.execution?.dispose();
+  state.interpreter = null;
+  state.disposePlayback();
+
+  const execution = new ExecutionService();
+  state.execution = execution;
+
+  const scriptPath = vscode.Uri.joinPath(context.extensionUri, "dist", "karelWorker.js").fsPath;
+  execution.createWorker(state.world, scriptPath);
+
+  const config = vscode.workspace.getConfiguration("vs-karel");
+  execution.setSpeed(config.get("executionSpeed", 500));
+  execution.setTurbo(config.get("executionMode", "animated") === "turbo");
+  execution.setMaxRecursionDepth(config.get("maxRecursionDepth", DEFAULT_MAX_RECURSION_DEPTH));
+  execution.setBudget(ExecutionService.configuredBudget());
+
+  const { success } = await execution.loadProgram(source);
+  if (!success) {
+    vscode.window.showErrorMessage(UIMessages.cannotRunWithErrors());
+    return;
+  }
+
+  setupInterpreterCallbacks(webview, false, execution);
+
+  webview.setStatus("running", UIMessages.executionStarted());
+  state.outputChannel.appendLine(UIMessages.executionStarted());
+
+  await execution.run();
+}
+
+/**
+ * Check if Run should compute the whole run first and then animate its trace.
+ */
+function shouldPrecompute(): boolean {
+  return vscode.workspace.getConfiguration("vs-karel").get("executionMode") === "precompute";
+}
+
+/**
+ * Execute the program headless at full speed, then animate the recorded trace
+ * with a timeline. The outcome is known before the animation starts, so errors
+ * are reported right away. A run that uses up its budget can be continued,
+ * which runs it again from the start with one more budget.
+ */
+async function runPrecomputed(webview: WebviewProvider, source: string): Promise<void> {
+  const state = StateManager.getInstance();
+  if (!state.world) {
+    return;
+  }
+
+  state.execution?.dispose();
+  state.execution = null;
+  state.interpreter?.stop();
+  state.interpreter = null;
+
+  const maxRecursionDepth = vscode.workspace
+    .getConfiguration("vs-karel")
+    .get("maxRecursionDepth", DEFAULT_MAX_RECURSION_DEPTH);
+  const configured = ExecutionService.configuredBudget();
+  const budget = { ...configured };
+  const map = state.world.toJSON();
+  let result = runHeadless(source, map, { trace: true, maxRecursionDepth, budget });
+  while (result.status === "paused" && result.error) {
+    const choice = await vscode.window.showWarningMessage(
+      result.error.message,
+      UIMessages.continueOption()
+    );
+    if (choice !== UIMessages.continueOption()) {
+      break;
+    }
+    budget.steps += configured.steps;
+    budget.control += configured.control;
+    result = runHeadless(source, map, { trace: true, maxRecursionDepth, budget });
+  }
+  if (result.status === "invalid" || !result.trace) {
+    vscode.window.showErrorMessage(UIMessages.cannotRunWithErrors());
+    return;
+  }
+
+  state.outputChannel.appendLine(UIMessages.executionStarted());
+  if (result.status === "paused" && result.error) {
+    state.outputChannel.appendLine(result.error.message);
+  } else if (result.error) {
+    const message = UIMessages.precomputedError(result.error.line ?? 0, result.error.message);
+    state.outputChannel.appendLine(message);
+    vscode.window.showWarningMessage(message);
+  }
+
+  await playTrace(webview, state.world, new TracePlayer(result.trace));
+}
+
 /**
  * Run the current Karel program (from topbar - always resets and prompts for map).
  */
@@ -149,8 +329,17 @@ export async function runProgram(context: vscode.ExtensionContext): Promise<void
   const webview = WebviewProvider.createOrShow(context.extensionUri);
   webview.loadWorld(state.world);
 
-  // Initialize interpreter
   const source = editor.document.getText();
+  if (shouldPrecompute()) {
+    await runPrecomputed(webview, source);
+    return;
+  }
+  if (shouldRunInWorker()) {
+    await runInWorker(context, webview, source);
+    return;
+  }
+
+  // Initialize interpreter
   if (!initializeInterpreter(source)) {
     return;
   }
@@ -213,8 +402,17 @@ export async function runFromWebview(context: vscode.ExtensionContext): Promise<
   const webview = WebviewProvider.createOrShow(context.extensionUri);
   webview.loadWorld(state.world);
 
-  // Initialize interpreter
   const source = state.sourceDocument.getText();
+  if (shouldPrecompute()) {
+    await runPrecomputed(webview, source);
+    return;
+  }
+  if (shouldRunInWorker()) {
+    await runInWorker(context, webview, source);
+    return;
+  }
+
+  // Initialize interpreter
   if (!initializeInterpreter(source)) {
     return;
   }
@@ -252,6 +450,8 @@ export async function stepProgram(context: vscode.ExtensionContext): Promise<voi
       return;
     }
 
+    // A stopped turbo run has no history yet: step back as far as stepping began
+    state.interpreter.enableHistory();
     try {
       const hasMore = state.interpreter.step();
       if (!hasMore) {
@@ -304,7 +504,7 @@ export async function stepProgram(context: vscode.ExtensionContext): Promise<voi
 
   // Initialize interpreter
   const source = state.sourceDocument.getText();
-  if (!initializeInterpreter(source)) {
+  if (!initializeInterpreter(source, true)) {
     return;
   }
 
@@ -328,14 +528,93 @@ export async function stepProgram(context: vscode.ExtensionContext): Promise<voi
   }
 }
 
+/**
+ * Move the in-process run to the state after `target` steps, forwards or
+ * backwards, and continue in step mode from there.
+ */
+function seekProgram(target: number): void {
+  const state = StateManager.getInstance();
+  const interpreter = state.interpreter;
+  const webview = WebviewProvider.currentPanel;
+  if (!interpreter || !interpreter.isStepInitialized() || !webview) {
+    return;
+  }
+
+  // Pause a running program and switch to step mode highlighting
+  interpreter.stop();
+  setupInterpreterCallbacks(webview, true);
+
+  try {
+    const hasMore = interpreter.seek(target);
+    webview.updateView();
+    if (hasMore) {
+      webview.setStatus("stepping", UIMessages.atStep(interpreter.getStepCount()));
+      if (interpreter.getStepCount() === 0) {
+        clearExecutionHighlight();
+      }
+    }
+  } catch (error) {
+    if (error instanceof Error) {
+      webview.setStatus("error", error.message);
+      state.outputChannel.appendLine(`Error: ${error.message}`);
+    }
+  }
+}
+
+/**
+ * Whether the run can be moved to another step. Runs on a worker keep no
+ * in-process interpreter to seek; the user is told so instead.
+ */
+function canSeek(): boolean {
+  const state = StateManager.getInstance();
+  if (!state.interpreter && state.execution) {
+    vscode.window.showInformationMessage(UIMessages.seekUnavailableInWorker());
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Go back one step.
+ */
+export function stepBackProgram(): void {
+  const interpreter = StateManager.getInstance().interpreter;
+  if (!canSeek()) {
+    return;
+  }
+  if (interpreter && interpreter.getStepCount() > 0) {
+    seekProgram(interpreter.getStepCount() - 1);
+  }
+}
+
+/**
+ * Prompt for a step number and move the run there.
+ */
+export async function goToStep(): Promise<void> {
+  const interpreter = StateManager.getInstance().interpreter;
+  if (!canSeek() || !interpreter || !interpreter.isStepInitialized()) {
+    return;
+  }
+
+  const input = await vscode.window.showInputBox({
+    prompt: UIMessages.goToStepPrompt(interpreter.getStepCount()),
+    validateInput: (value) => (/^\d+$/.test(value.trim()) ? null : UIMessages.invalidStepNumber()),
+  });
+  if (input !== undefined) {
+    seekProgram(parseInt(input.trim(), 10));
+  }
+}
+
 /**
  * Stop program execution.
  */
 export function stopProgram(): void {
   const state = StateManager.getInstance();
 
-  if (state.interpreter) {
-    state.interpreter.stop();
+  if (state.interpreter || state.execution || state.playback) {
+    state.interpreter?.stop();
+    state.execution?.stop();
+    state.playback?.pause();
     const webview = WebviewProvider.currentPanel;
     if (webview) {
       webview.setStatus("stopped", UIMessages.executionStopped());
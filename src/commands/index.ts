@@ -2,7 +2,16 @@
  * Command Handlers - Barrel exports
  */
 
-export { runProgram, runFromWebview, stepProgram, stopProgram } from "./executionCommands";
+export {
+  runProgram,
+  runFromWebview,
+  stepProgram,
+  stepBackProgram,
+  goToStep,
+  stopProgram,
+} from "./executionCommands";
 export { changeProgram } from "./fileCommands";
 export { resetWorld, loadMapFile, reloadMapFile } from "./worldCommands";
 export { toggleErrorHighlighting, openVisualizer } from "./uiCommands";
+export { runBatchCommand } from "./batchCommands";
+export { recordTrace, replayTrace, seekTimeline } from "./traceCommands";
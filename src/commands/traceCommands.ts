@@ -0,0 +1,193 @@
+/**
+ * Trace Commands
+ * Records execution traces (.kltrace) and plays them back without re-executing
+ */
+
+import * as vscode from "vscode";
+import * as path from "path";
+import { World, TracePlayer, TraceStatus, runHeadless } from "@/interpreter";
+import { WebviewProvider } from "@/providers";
+import { StateManager, FileService, TracePlaybackService, ExecutionService } from "@/services";
+import { UIMessages } from "@/i18n/messages";
+
+/**
+ * Use the active Karel instructions file, the current program, or prompt for one.
+ */
+async function getProgramDocument(): Promise<vscode.TextDocument | undefined> {
+  const editor = vscode.window.activeTextEditor;
+  if (editor && editor.document.languageId === "karel-instructions") {
+    return editor.document;
+  }
+
+  const state = StateManager.getInstance();
+  if (state.sourceDocument) {
+    return state.sourceDocument;
+  }
+
+  const fileService = FileService.getInstance();
+  const uri = await fileService.selectProgramFile();
+  return uri ? fileService.openFile(uri) : undefined;
+}
+
+/**
+ * Run the program headless on the current world and save its trace.
+ */
+export async function recordTrace(context: vscode.ExtensionContext): Promise<void> {
+  const state = StateManager.getInstance();
+  const fileService = FileService.getInstance();
+
+  const document = await getProgramDocument();
+  if (!document) {
+    return;
+  }
+
+  if (!state.world) {
+    const world = await fileService.promptAndLoadMapFile();
+    if (!world) {
+      return;
+    }
+    state.world = world;
+    WebviewProvider.createOrShow(context.extensionUri).loadWorld(world);
+  }
+
+  const result = runHeadless(document.getText(), state.world.toJSON(), {
+    trace: true,
+    budget: ExecutionService.configuredBudget(),
+  });
+  if (result.status === "invalid" || !result.trace) {
+    vscode.window.showErrorMessage(UIMessages.cannotRunWithErrors());
+    return;
+  }
+
+  const defaultPath = document.uri.fsPath.replace(/\.kli$/, "") + ".kltrace";
+  const uri = await fileService.selectTraceSaveLocation(vscode.Uri.file(defaultPath));
+  if (!uri) {
+    return;
+  }
+
+  await vscode.workspace.fs.writeFile(uri, result.trace);
+  const kb = (result.trace.length / 1024).toFixed(1);
+  state.outputChannel.appendLine(
+    UIMessages.traceSaved(path.basename(uri.fsPath), result.steps, kb)
+  );
+  if (result.error) {
+    state.outputChannel.appendLine(`Error: ${result.error.message}`);
+  }
+}
+
+/**
+ * Animate a trace onto a world already shown in the visualizer, with a
+ * timeline for seeking. Follows the executionSpeed and executionMode settings
+ * like a normal run.
+ */
+export async function playTrace(
+  webview: WebviewProvider,
+  world: World,
+  player: TracePlayer
+): Promise<void> {
+  const state = StateManager.getInstance();
+  state.disposePlayback();
+
+  const playback = new TracePlaybackService(world, player);
+  state.playback = playback;
+
+  playback.onFrame = (position, line) => {
+    webview.updateView();
+    webview.setTimelinePosition(position);
+    if (line > 0) {
+      webview.highlightLine(line);
+    }
+  };
+
+  playback.onEnd = (end) => {
+    if (end?.status === TraceStatus.Completed) {
+      webview.setStatus("completed", UIMessages.executionCompleted());
+      state.outputChannel.appendLine(UIMessages.executionCompleted());
+    } else if (end?.status === TraceStatus.Error && end.message) {
+      webview.highlightLine(end.line);
+      webview.setStatus("error", end.message);
+      state.outputChannel.appendLine(`Error: ${end.message}`);
+    } else {
+      webview.setStatus("stopped", end?.message || UIMessages.replayStopped());
+    }
+  };
+
+  const end = player.end;
+  webview.showTimeline(player.totalSteps, {
+    status:
+      end?.status === TraceStatus.Completed
+        ? "completed"
+        : end?.status === TraceStatus.Error
+          ? "error"
+          : "stopped",
+    message: end?.message,
+  });
+
+  const config = vscode.workspace.getConfiguration("vs-karel");
+  const speed = config.get("executionSpeed", 500);
+  const turbo = config.get("executionMode", "animated") === "turbo";
+
+  webview.setStatus("running", UIMessages.replayStarted());
+  try {
+    await playback.play(speed, turbo);
+  } catch (error) {
+    playback.pause();
+    webview.setStatus("error", (error as Error).message);
+    state.outputChannel.appendLine(`Error: ${(error as Error).message}`);
+  }
+}
+
+/**
+ * Load a trace and play it back in the visualizer.
+ */
+export async function replayTrace(context: vscode.ExtensionContext): Promise<void> {
+  const state = StateManager.getInstance();
+  const fileService = FileService.getInstance();
+
+  const uri = await fileService.selectTraceFile();
+  if (!uri) {
+    return;
+  }
+
+  let player: TracePlayer;
+  try {
+    player = new TracePlayer(await vscode.workspace.fs.readFile(uri));
+  } catch (error) {
+    vscode.window.showErrorMessage((error as Error).message);
+    return;
+  }
+
+  // A replay replaces whatever was running
+  state.interpreter?.stop();
+  state.interpreter = null;
+  state.execution?.dispose();
+  state.execution = null;
+
+  const world = World.fromJSON(player.map);
+  state.world = world;
+  const webview = WebviewProvider.createOrShow(context.extensionUri);
+  webview.loadWorld(world);
+
+  state.outputChannel.appendLine(UIMessages.replayStarted());
+  await playTrace(webview, world, player);
+}
+
+/**
+ * Move the current playback to a step (from the visualizer's timeline).
+ */
+export function seekTimeline(step: number): void {
+  const state = StateManager.getInstance();
+  const webview = WebviewProvider.currentPanel;
+  if (!state.playback || !webview) {
+    return;
+  }
+
+  try {
+    state.playback.seek(step);
+    if (!state.playback.isPlaying() && step < state.playback.totalSteps) {
+      webview.setStatus("stopped", UIMessages.timelineStep(step, state.playback.totalSteps));
+    }
+  } catch (error) {
+    webview.setStatus("error", (error as Error).message);
+  }
+}
@@ -16,6 +16,7 @@ import { UIMessages } from "@/i18n/messages";
  */
 export function resetWorld(context: vscode.ExtensionContext): void {
   const state = StateManager.getInstance();
+  state.disposePlayback();
 
   if (state.world) {
     state.world.reset();
@@ -29,6 +30,11 @@ export function resetWorld(context: vscode.ExtensionContext): void {
     state.interpreter.reset();
     clearExecutionHighlight();
   }
+  if (state.execution) {
+    // The worker mirrors into state.world, which was reset above
+    state.execution.dispose();
+    state.execution = null;
+  }
   // Keep sourceDocument reference so run/step can reuse it
 }
 
@@ -94,6 +100,10 @@ export function reloadMapFile(
       state.interpreter.reset();
       state.sourceDocument = null;
     }
+    if (state.execution) {
+      state.execution.dispose();
+      state.execution = null;
+    }
 
     vscode.window.showInformationMessage(UIMessages.mapReloaded(filename));
     state.outputChannel.appendLine(UIMessages.mapReloaded(filename));
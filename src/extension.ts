@@ -49,6 +49,8 @@ export function activate(context: vscode.ExtensionContext): void {
       commands.changeProgram(context)
     ),
     vscode.commands.registerCommand("vs-karel.step", () => commands.stepProgram(context)),
+    vscode.commands.registerCommand("vs-karel.stepBack", () => commands.stepBackProgram()),
+    vscode.commands.registerCommand("vs-karel.goToStep", () => commands.goToStep()),
     vscode.commands.registerCommand("vs-karel.stop", () => commands.stopProgram()),
     vscode.commands.registerCommand("vs-karel.reset", () => commands.resetWorld(context)),
     vscode.commands.registerCommand("vs-karel.toggleErrorHighlighting", () =>
@@ -56,6 +58,13 @@ export function activate(context: vscode.ExtensionContext): void {
     ),
     vscode.commands.registerCommand("vs-karel.openVisualizer", () =>
       commands.openVisualizer(context)
+    ),
+    vscode.commands.registerCommand("vs-karel.runBatch", () => commands.runBatchCommand(context)),
+    vscode.commands.registerCommand("vs-karel.recordTrace", () => commands.recordTrace(context)),
+    vscode.commands.registerCommand("vs-karel.replayTrace", () => commands.replayTrace(context)),
+    // Internal: sent by the visualizer's timeline
+    vscode.commands.registerCommand("vs-karel.seekTimeline", (step: number) =>
+      commands.seekTimeline(step)
     )
   );
 
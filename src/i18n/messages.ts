@@ -50,12 +50,24 @@ export const ErrorMessages = {
     format("Unknown condition '{0}' at line {1}", name, line),
   invalidIterateCount: (line: number) =>
     format("Invalid ITERATE count at line {0}: must be a positive integer", line),
+  iterateCountTooLarge: (line: number, max: number) =>
+    format("ITERATE count at line {0} is too large: the limit is {1}", line, max),
 
   // Execution errors
   programNotLoaded: () => "No program loaded",
   executionStopped: () => "Execution was stopped",
-  maxIterationsReached: (max: number) =>
-    format("Maximum iterations ({0}) reached: possible infinite loop", max),
+  stepBudgetExhausted: (max: number) =>
+    format("Paused after {0} steps: the step budget is used up", max),
+  controlBudgetExhausted: (max: number) =>
+    format("Paused after {0} control instructions: the control budget is used up", max),
+  recursionLimitReached: (max: number, chain: string) =>
+    format("Maximum recursion depth ({0}) reached: {1}", max, chain),
+  infiniteLoop: (lines: string) =>
+    format("Infinite loop detected: the program state repeats (lines {0})", lines),
+  historyUnavailable: () => "Cannot step back that far: turbo runs keep no execution history",
+
+  // Trace errors
+  invalidTrace: () => "Invalid or corrupted trace file",
 };
 
 /**
@@ -66,11 +78,31 @@ export const UIMessages = {
   errorHighlightingDisabled: () => "Karel error highlighting disabled",
   executionStarted: () => "Karel execution started",
   executionCompleted: () => "Karel execution completed",
+  executionContinued: () => "Karel execution continued with a new budget",
   executionStopped: () => "Execution stopped",
   stepMode: () => "Step mode - press Step to advance",
+  atStep: (step: number) => format("Step {0} - press Back or Step to move", step),
+  goToStepPrompt: (current: number) => format("Go to step (currently at step {0})", current),
+  invalidStepNumber: () => "Enter a non-negative whole number",
+  seekUnavailableInWorker: () =>
+    "Step Back and Go to Step are not available for runs on a worker thread (vs-karel.runInWorker)",
   noActiveFile: () => "No active Karel file",
   selectMapFile: () => "Select a Karel map file (.klm)",
   selectInstructionsFile: () => "Select Karel Instructions File",
+  selectMapFolder: () => "Select a folder of Karel map files (.klm)",
+  noMapsFound: (folder: string) => format("No .klm files found in {0}", folder),
+  batchRunning: (count: number) => format("Running program on {0} maps", count),
+  batchCompleted: (passed: number, total: number) =>
+    format("Batch run finished: {0}/{1} maps passed", passed, total),
+  selectTraceFile: () => "Select a Karel execution trace (.kltrace)",
+  saveTraceFile: () => "Save Karel execution trace",
+  traceSaved: (filename: string, steps: number, kb: string) =>
+    format("Trace saved to {0}: {1} steps, {2} KB", filename, steps, kb),
+  replayStarted: () => "Replaying trace",
+  replayStopped: () => "Trace ended before the program finished",
+  timelineStep: (step: number, total: number) => format("Step {0} of {1}", step, total),
+  precomputedError: (line: number, error: string) =>
+    format("The program will stop with an error at line {0}: {1}", line, error),
   conversionComplete: (filename: string) => format("Map converted successfully: {0}", filename),
   mapReloaded: (filename: string) => format("Map reloaded: {0}", filename),
   mapReloadError: (filename: string, error: string) =>
@@ -0,0 +1,136 @@
+/**
+ * Batch runner: one program against many maps on a worker_thread pool.
+ */
+
+import * as os from "os";
+import * as path from "path";
+import { Worker } from "worker_threads";
+import {
+  BatchJob,
+  BatchJobResult,
+  BatchResult,
+  BatchWorkerInit,
+} from "@/interpreter/batch/protocol";
+import { ExecutionBudget } from "@/interpreter/execution/budget";
+
+export interface BatchOptions {
+  /** Path of the bundled pool worker script (dist/batchWorker.js). */
+  scriptPath: string;
+  /** Pool size. Defaults to the number of CPUs. */
+  workers?: number;
+  /** Step and control limits of each run (DEFAULT_EXECUTION_BUDGET for those unset). */
+  budget?: Partial<ExecutionBudget>;
+  /** Called as each map finishes, in completion order. */
+  onResult?: (result: BatchResult) => void;
+}
+
+/**
+ * Run a program on every map, spreading the maps over a pool of workers.
+ * Each map gets its own World and Interpreter. Results are returned in the
+ * order of `mapPaths`.
+ */
+export function runBatch(
+  source: string,
+  mapPaths: string[],
+  options: BatchOptions
+): Promise<BatchResult[]> {
+  const results: BatchResult[] = new Array(mapPaths.length);
+  const poolSize = Math.max(1, Math.min(options.workers ?? os.cpus().length, mapPaths.length));
+  let next = 0;
+
+  const record = (index: number, result: BatchResult): void => {
+    results[index] = result;
+    options.onResult?.(result);
+  };
+
+  // Each pool slot pulls the next map as soon as its worker is free, so slow
+  // maps do not hold up the rest of the queue.
+  const startWorker = (): Promise<void> =>
+    new Promise((resolve) => {
+      const initData: BatchWorkerInit = { source, budget: options.budget };
+      const worker = new Worker(options.scriptPath, { workerData: initData });
+      let current = -1;
+      let finished = false; // set once the slot is done with this worker
+
+      const dispatch = (): void => {
+        if (next >= mapPaths.length) {
+          current = -1;
+          finished = true;
+          worker.terminate();
+          resolve();
+          return;
+        }
+        current = next++;
+        const job: BatchJob = { index: current, mapPath: mapPaths[current] };
+        worker.postMessage(job);
+      };
+
+      // A crashed worker fails its current map; a fresh worker takes over the slot.
+      // A crash can emit both "error" and "exit", so only the first is handled.
+      const crash = (message: string): void => {
+        if (finished) {
+          return;
+        }
+        finished = true;
+        worker.removeAllListeners();
+        worker.terminate();
+        if (current >= 0) {
+          record(current, crashedResult(mapPaths[current], message));
+        }
+        resolve(startWorker());
+      };
+
+      worker.on("message", (message: BatchJobResult) => {
+        record(message.index, message.result);
+        dispatch();
+      });
+      worker.on("error", (error) => crash(error.message));
+      worker.on("exit", (code) => crash(`Worker exited with code ${code}`));
+
+      dispatch();
+    });
+
+  return Promise.all(Array.from({ length: poolSize }, startWorker)).then(() => results);
+}
+
+function crashedResult(mapPath: string, message: string): BatchResult {
+  return { map: mapPath, status: "error", passed: false, steps: 0, timeMs: 0, error: message };
+}
+
+/**
+ * Format results as a plain-text table followed by a pass count.
+ * @param basePath - Map paths are shown relative to this directory
+ */
+export function formatBatchSummary(
+  results: BatchResult[],
+  elapsedMs: number,
+  basePath: string = process.cwd()
+): string {
+  const header = ["Map", "Result", "Steps", "Time (ms)", "Error"];
+  const rows = results.map((r) => [
+    path.relative(basePath, r.map) || r.map,
+    r.passed ? "PASS" : "FAIL",
+    r.steps.toString(),
+    r.timeMs.toFixed(1),
+    r.error ? (r.line ? `line ${r.line}: ${r.error}` : r.error) : "",
+  ]);
+
+  // Pad every column but the last to its widest cell
+  const widths = header.map((title, column) =>
+    Math.max(title.length, ...rows.map((row) => row[column].length))
+  );
+  const formatRow = (row: string[]): string =>
+    row
+      .map((cell, column) => (column < row.length - 1 ? cell.padEnd(widths[column]) : cell))
+      .join("  ")
+      .trimEnd();
+
+  const passed = results.filter((r) => r.passed).length;
+  return [
+    formatRow(header),
+    formatRow(widths.map((width) => "-".repeat(width))),
+    ...rows.map(formatRow),
+    "",
+    `Passed ${passed}/${results.length} maps in ${elapsedMs.toFixed(0)} ms`,
+  ].join("\n");
+}
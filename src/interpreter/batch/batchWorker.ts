@@ -0,0 +1,38 @@
+/**
+ * Batch pool worker entry point.
+ *
+ * Runs the program it was started with on each map it is sent, each time with
+ * a fresh World and Interpreter. Built as a separate webpack entry
+ * (dist/batchWorker.js).
+ */
+
+import * as fs from "fs";
+import { parentPort, workerData } from "worker_threads";
+import { KarelMap } from "@/interpreter/world";
+import { runHeadless } from "@/interpreter/execution/headless";
+import {
+  BatchJob,
+  BatchJobResult,
+  BatchResult,
+  BatchWorkerInit,
+} from "@/interpreter/batch/protocol";
+import { toBatchResult, invalidMapResult } from "@/interpreter/batch/results";
+
+const port = parentPort!;
+const { source, budget } = workerData as BatchWorkerInit;
+
+function runJob(mapPath: string): BatchResult {
+  const start = performance.now();
+  try {
+    const map = JSON.parse(fs.readFileSync(mapPath, "utf8")) as KarelMap;
+    return toBatchResult(mapPath, runHeadless(source, map, { budget }));
+  } catch (e) {
+    // Unreadable file, bad JSON or invalid map contents (e.g. non-adjacent walls)
+    return invalidMapResult(mapPath, (e as Error).message, performance.now() - start);
+  }
+}
+
+port.on("message", (job: BatchJob) => {
+  const message: BatchJobResult = { index: job.index, result: runJob(job.mapPath) };
+  port.postMessage(message);
+});
@@ -0,0 +1,100 @@
+/**
+ * In-process batch runs on the lockstep engine.
+ */
+
+import * as fs from "fs";
+import { KarelMap } from "@/interpreter/world";
+import { compileSource } from "@/interpreter/execution/compiler";
+import { runHeadless } from "@/interpreter/execution/headless";
+import { LockstepEngine, LockstepResult } from "@/interpreter/execution/lockstep";
+import { ExecutionBudget } from "@/interpreter/execution/budget";
+import { BatchResult } from "@/interpreter/batch/protocol";
+import { toBatchResult, invalidMapResult } from "@/interpreter/batch/results";
+
+/**
+ * Run a program on every map, running maps that share dimensions and walls
+ * together on a LockstepEngine. Other maps run one at a time.
+ *
+ * Suited to many small maps, where starting a worker per task costs more than
+ * the run itself. Per-map times are the group's time divided among its maps.
+ */
+export function runLockstepBatch(
+  source: string,
+  mapPaths: string[],
+  budget: Partial<ExecutionBudget> = {}
+): BatchResult[] {
+  const results: BatchResult[] = new Array(mapPaths.length);
+  const { program } = compileSource(source);
+
+  // Group readable maps by dimensions and walls
+  const groups = new Map<string, { index: number; map: KarelMap }[]>();
+  mapPaths.forEach((mapPath, index) => {
+    let map: KarelMap;
+    try {
+      map = JSON.parse(fs.readFileSync(mapPath, "utf8")) as KarelMap;
+    } catch (e) {
+      results[index] = invalidMapResult(mapPath, (e as Error).message);
+      return;
+    }
+    const key = LockstepEngine.layoutKey(map);
+    const group = groups.get(key) ?? [];
+    group.push({ index, map });
+    groups.set(key, group);
+  });
+
+  for (const group of groups.values()) {
+    const maps = group.map((entry) => entry.map);
+    if (!program || group.length < 2 || !LockstepEngine.canRun(maps)) {
+      for (const { index, map } of group) {
+        results[index] = runSingle(source, mapPaths[index], map, budget);
+      }
+      continue;
+    }
+
+    const start = performance.now();
+    let outcomes: LockstepResult[];
+    try {
+      outcomes = new LockstepEngine(program, maps, budget).run();
+    } catch (e) {
+      // Invalid walls: every map in the group shares them
+      for (const { index } of group) {
+        results[index] = invalidMapResult(mapPaths[index], (e as Error).message);
+      }
+      continue;
+    }
+    const timeMs = (performance.now() - start) / group.length;
+
+    group.forEach(({ index, map }, i) => {
+      const outcome = outcomes[i];
+      if (outcome.status === "looping") {
+        // The interpreter finds the same loop and names its lines
+        results[index] = runSingle(source, mapPaths[index], map, budget);
+        return;
+      }
+      results[index] = {
+        map: mapPaths[index],
+        status: outcome.status,
+        passed: outcome.status === "completed",
+        steps: outcome.steps,
+        timeMs,
+        error: outcome.error?.message,
+        line: outcome.error?.line,
+      };
+    });
+  }
+
+  return results;
+}
+
+function runSingle(
+  source: string,
+  mapPath: string,
+  map: KarelMap,
+  budget: Partial<ExecutionBudget>
+): BatchResult {
+  try {
+    return toBatchResult(mapPath, runHeadless(source, map, { budget }));
+  } catch (e) {
+    return invalidMapResult(mapPath, (e as Error).message);
+  }
+}
@@ -0,0 +1,86 @@
+/**
+ * Expansion of map folders and glob patterns into .klm file paths.
+ */
+
+import * as fs from "fs";
+import * as path from "path";
+
+const GLOB_CHARS = /[*?]/;
+
+/**
+ * Resolve a folder, a glob pattern or a file path to a sorted list of .klm files.
+ *
+ * - A folder yields the .klm files directly inside it.
+ * - A glob supports `*` and `?` within a path segment and `**` for any number
+ *   of folders, e.g. `tests/**\/*.klm`.
+ * - Anything else is returned as is when the file exists.
+ */
+export function findMapFiles(pattern: string): string[] {
+  if (!GLOB_CHARS.test(pattern)) {
+    if (!fs.existsSync(pattern)) {
+      return [];
+    }
+    if (fs.statSync(pattern).isDirectory()) {
+      return fs
+        .readdirSync(pattern)
+        .filter((name) => name.toLowerCase().endsWith(".klm"))
+        .map((name) => path.join(pattern, name))
+        .sort();
+    }
+    return [pattern];
+  }
+
+  // Walk from the deepest folder that has no wildcard in it
+  const segments = pattern.split(/[\\/]/);
+  const firstGlob = segments.findIndex((segment) => GLOB_CHARS.test(segment));
+  const base = segments.slice(0, firstGlob).join(path.sep) || ".";
+  const matcher = globToRegExp(segments.slice(firstGlob).join("/"));
+  const recursive = segments.slice(firstGlob).length > 1 || pattern.includes("**");
+
+  const matches: string[] = [];
+  const walk = (dir: string, relative: string): void => {
+    let entries: fs.Dirent[];
+    try {
+      entries = fs.readdirSync(dir, { withFileTypes: true });
+    } catch {
+      return;
+    }
+    for (const entry of entries) {
+      const entryRelative = relative ? `${relative}/${entry.name}` : entry.name;
+      const entryPath = path.join(dir, entry.name);
+      if (entry.isDirectory()) {
+        if (recursive) {
+          walk(entryPath, entryRelative);
+        }
+      } else if (matcher.test(entryRelative)) {
+        matches.push(entryPath);
+      }
+    }
+  };
+  walk(base, "");
+  return matches.sort();
+}
+
+function globToRegExp(glob: string): RegExp {
+  let source = "";
+  for (let i = 0; i < glob.length; i++) {
+    const char = glob[i];
+    if (char === "*" && glob[i + 1] === "*") {
+      // "**/" matches zero or more folders, a trailing "**" anything
+      if (glob[i + 2] === "/") {
+        source += "(?:.*/)?";
+        i += 2;
+      } else {
+        source += ".*";
+        i += 1;
+      }
+    } else if (char === "*") {
+      source += "[^/]*";
+    } else if (char === "?") {
+      source += "[^/]";
+    } else {
+      source += char.replace(/[.+^${}()|[\]\\]/g, "\\$&");
+    }
+  }
+  return new RegExp(`^${source}$`);
+}
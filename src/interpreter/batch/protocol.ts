@@ -0,0 +1,40 @@
+/**
+ * Messages between the batch runner and its pool workers.
+ */
+
+import type { HeadlessStatus } from "@/interpreter/execution/headless";
+import type { ExecutionBudget } from "@/interpreter/execution/budget";
+
+/**
+ * Result of running the program on one map.
+ */
+export interface BatchResult {
+  /** Path of the map file. */
+  map: string;
+  /** "invalid" also covers maps that could not be read or parsed. */
+  status: HeadlessStatus;
+  /** True when the program completed without errors. */
+  passed: boolean;
+  steps: number;
+  timeMs: number;
+  error?: string;
+  line?: number;
+}
+
+/**
+ * workerData of a batch worker: the program and budget shared by every job.
+ */
+export interface BatchWorkerInit {
+  source: string;
+  budget?: Partial<ExecutionBudget>;
+}
+
+export interface BatchJob {
+  index: number;
+  mapPath: string;
+}
+
+export interface BatchJobResult {
+  index: number;
+  result: BatchResult;
+}
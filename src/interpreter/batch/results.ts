@@ -0,0 +1,33 @@
+/**
+ * Conversion of run outcomes into batch results.
+ */
+
+import type { HeadlessResult } from "@/interpreter/execution/headless";
+import { BatchResult } from "@/interpreter/batch/protocol";
+
+/**
+ * Summarize a headless run (parse errors report their first diagnostic).
+ */
+export function toBatchResult(mapPath: string, result: HeadlessResult): BatchResult {
+  const firstDiagnostic = result.diagnostics?.[0];
+  return {
+    map: mapPath,
+    status: result.status,
+    passed: result.status === "completed",
+    steps: result.steps,
+    timeMs: result.timeMs,
+    error: result.error?.message ?? firstDiagnostic?.message,
+    line: result.error?.line ?? firstDiagnostic?.line,
+  };
+}
+
+/**
+ * Result for a map that could not be read or is not a valid world.
+ */
+export function invalidMapResult(
+  mapPath: string,
+  message: string,
+  timeMs: number = 0
+): BatchResult {
+  return { map: mapPath, status: "invalid", passed: false, steps: 0, timeMs, error: message };
+}
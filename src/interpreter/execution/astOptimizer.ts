@@ -0,0 +1,254 @@
+/**
+ * AST optimizer for the compiled tiers (JavaScript and WebAssembly).
+ *
+ * Rewrites a resolved program so it dispatches fewer primitives:
+ * - runs of turnleft fold into one turn by the count mod 4
+ * - ITERATE loops whose body folds completely fuse into a single turn, and
+ *   other small ones are unrolled
+ * - empty blocks and IFs, and statements after turnoff, are dropped
+ * - calls to tiny custom instructions are inlined
+ *
+ * Whatever is removed is kept as weights on FoldedNodes (steps, VM
+ * instructions, and the line of the last step), so an optimized run reports
+ * the same step count, final line and errors as the VM, and never fewer
+ * instructions than the unoptimized layout. Primitives that can fail keep
+ * their own nodes and lines.
+ *
+ * The VM keeps running the unoptimized program, since stepping, traces and
+ * history need every primitive.
+ */
+
+import {
+  ASTNode,
+  ProgramNode,
+  FoldedNode,
+  BlockNode,
+  IterateNode,
+} from "@/interpreter/types/ast";
+import { BuiltIn } from "@/interpreter/parsing/constants";
+
+/**
+ * Largest custom instruction body (in nodes, after optimizing it) that is
+ * inlined at each call.
+ */
+const INLINE_LIMIT = 4;
+
+/**
+ * Largest ITERATE loop (body nodes times count) that is unrolled.
+ */
+const UNROLL_LIMIT = 16;
+
+/**
+ * Optimize a program whose calls have been bound by resolveCalls().
+ * Returns a new tree; the original is not modified. Definitions keep their
+ * indices, so calls that are not inlined still resolve.
+ */
+export function optimizeAst(ast: ProgramNode): ProgramNode {
+  return new AstOptimizer(ast).optimize();
+}
+
+function folded(turns: number, steps: number, iterations: number, line: number): FoldedNode {
+  return { type: "folded", turns, steps, iterations, line };
+}
+
+/**
+ * Number of nodes in a statement list, counting nested ones.
+ */
+function size(statements: ASTNode[]): number {
+  let total = 0;
+  for (const node of statements) {
+    total++;
+    switch (node.type) {
+      case "if":
+        total += size(node.thenBranch.statements);
+        total += node.elseBranch ? size(node.elseBranch.statements) : 0;
+        break;
+      case "while":
+      case "iterate":
+        total += size(node.body.statements);
+        break;
+      case "block":
+        total += size(node.statements);
+        break;
+    }
+  }
+  return total;
+}
+
+function block(statements: ASTNode[]): BlockNode {
+  return { type: "block", statements };
+}
+
+class AstOptimizer {
+  private readonly ast: ProgramNode;
+  private readonly bodies: (ASTNode[] | undefined)[] = [];
+  private readonly visiting = new Set<number>();
+
+  constructor(ast: ProgramNode) {
+    this.ast = ast;
+  }
+
+  optimize(): ProgramNode {
+    return {
+      type: "program",
+      definitions: this.ast.definitions.map((def, index) => ({
+        ...def,
+        body: block(this.body(index) ?? def.body.statements),
+      })),
+      execution: { type: "execution", statements: this.statements(this.ast.execution.statements) },
+    };
+  }
+
+  /**
+   * Optimized body of a custom instruction, or null while it is being
+   * optimized (a recursive call, which must not be inlined).
+   */
+  private body(index: number): ASTNode[] | null {
+    const known = this.bodies[index];
+    if (known) {
+      return known;
+    }
+    if (this.visiting.has(index)) {
+      return null;
+    }
+    this.visiting.add(index);
+    const optimized = this.statements(this.ast.definitions[index].body.statements);
+    this.visiting.delete(index);
+    this.bodies[index] = optimized;
+    return optimized;
+  }
+
+  private statements(statements: ASTNode[]): ASTNode[] {
+    const out: ASTNode[] = [];
+    for (const node of statements) {
+      if (this.statement(node, out)) {
+        break; // turnoff: nothing after it runs
+      }
+    }
+    return out;
+  }
+
+  /**
+   * Append the optimized form of a statement. Returns true if it always
+   * ends the program.
+   */
+  private statement(node: ASTNode, out: ASTNode[]): boolean {
+    switch (node.type) {
+      case "call": {
+        const target = node.target;
+        if (target?.kind === "builtin") {
+          if (target.builtIn === BuiltIn.TurnLeft) {
+            this.append(out, folded(1, 1, 1, node.line));
+            return false;
+          }
+          out.push(node);
+          return target.builtIn === BuiltIn.TurnOff;
+        }
+        const body = target ? this.body(target.index) : null;
+        if (!body || size(body) > INLINE_LIMIT) {
+          out.push(node);
+          return false;
+        }
+        // The call's own step and instruction, the body, then its Return
+        this.append(out, folded(0, 1, 1, node.line));
+        for (const inner of body) {
+          if (this.statement(inner, out)) {
+            return true;
+          }
+        }
+        this.append(out, folded(0, 0, 1, 0));
+        return false;
+      }
+      case "if": {
+        const thenBranch = this.statements(node.thenBranch.statements);
+        const elseBranch = node.elseBranch && this.statements(node.elseBranch.statements);
+        if (thenBranch.length === 0 && !elseBranch) {
+          this.append(out, folded(0, 0, 1, 0)); // conditions have no effects
+        } else {
+          out.push({
+            ...node,
+            thenBranch: block(thenBranch),
+            elseBranch: elseBranch && block(elseBranch),
+          });
+        }
+        return false;
+      }
+      case "while":
+        out.push({ ...node, body: block(this.statements(node.body.statements)) });
+        return false;
+      case "iterate":
+        return this.iterate(node.count, this.statements(node.body.statements), node, out);
+      case "block":
+        for (const inner of node.statements) {
+          if (this.statement(inner, out)) {
+            return true;
+          }
+        }
+        return false;
+      case "folded":
+        this.append(out, node);
+        return false;
+      default:
+        out.push(node);
+        return false;
+    }
+  }
+
+  private iterate(count: number, body: ASTNode[], node: IterateNode, out: ASTNode[]): boolean {
+    if (count <= 0) {
+      return false;
+    }
+
+    // IterBegin, then the body and an IterNext per iteration
+    // Folding only while the weights stay exact (turns <= steps <= iterations)
+    const once = body.every((inner) => inner.type === "folded")
+      ? (body as FoldedNode[]).reduce(merge, folded(0, 0, 1, 0))
+      : null;
+    if (once && Number.isSafeInteger(1 + count * once.iterations)) {
+      this.append(
+        out,
+        folded(count * once.turns, count * once.steps, 1 + count * once.iterations, once.line)
+      );
+      return false;
+    }
+
+    if (count * size(body) > UNROLL_LIMIT) {
+      out.push({ ...node, body: block(body) });
+      return false;
+    }
+    this.append(out, folded(0, 0, 1, 0));
+    for (let i = 0; i < count; i++) {
+      for (const inner of body) {
+        if (this.statement(inner, out)) {
+          return true;
+        }
+      }
+      this.append(out, folded(0, 0, 1, 0));
+    }
+    return false;
+  }
+
+  /**
+   * Append a folded node, merging it into a folded node right before it.
+   */
+  private append(out: ASTNode[], node: FoldedNode): void {
+    const last = out[out.length - 1];
+    if (last?.type === "folded" && Number.isSafeInteger(last.iterations + node.iterations)) {
+      out[out.length - 1] = merge(last, node);
+    } else {
+      out.push(node);
+    }
+  }
+}
+
+/**
+ * One folded node that runs `a` then `b`.
+ */
+function merge(a: FoldedNode, b: FoldedNode): FoldedNode {
+  return folded(
+    a.turns + b.turns,
+    a.steps + b.steps,
+    a.iterations + b.iterations,
+    b.steps > 0 ? b.line : a.line
+  );
+}
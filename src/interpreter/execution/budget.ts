@@ -0,0 +1,48 @@
+/**
+ * Instruction budget of a run.
+ */
+
+import { ErrorMessages } from "@/i18n/messages";
+
+/**
+ * How much a run may execute before it pauses. The two kinds of work are
+ * counted separately:
+ * - steps: primitives and custom instruction calls
+ * - control: branches, jumps, returns and loop counter updates
+ */
+export interface ExecutionBudget {
+  steps: number;
+  control: number;
+}
+
+export type BudgetKind = keyof ExecutionBudget;
+
+/**
+ * Default budget: enough for long maze runs on large maps, while programs that
+ * never finish (and never repeat a state) still pause within a few seconds.
+ */
+export const DEFAULT_EXECUTION_BUDGET: Readonly<ExecutionBudget> = {
+  steps: 50_000_000,
+  control: 250_000_000,
+};
+
+/**
+ * Budget with every limit a positive integer (unset ones take the default).
+ */
+export function normalizeBudget(budget: Partial<ExecutionBudget>): ExecutionBudget {
+  const limit = (value: number | undefined, fallback: number): number =>
+    value === undefined || Number.isNaN(value) ? fallback : Math.max(1, Math.floor(value));
+  return {
+    steps: limit(budget.steps, DEFAULT_EXECUTION_BUDGET.steps),
+    control: limit(budget.control, DEFAULT_EXECUTION_BUDGET.control),
+  };
+}
+
+/**
+ * Why a run paused, given the budget that ran out and the count it reached.
+ */
+export function budgetExhaustedMessage(kind: BudgetKind, limit: number): string {
+  return kind === "steps"
+    ? ErrorMessages.stepBudgetExhausted(limit)
+    : ErrorMessages.controlBudgetExhausted(limit);
+}
@@ -0,0 +1,68 @@
+/**
+ * Bytecode definitions for the Karel virtual machine.
+ */
+
+/**
+ * Instruction opcodes.
+ */
+export enum OpCode {
+  // Primitives (each one is a visible step)
+  Move,
+  TurnLeft,
+  PickBeeper,
+  PutBeeper,
+  TurnOff,
+
+  // Control flow
+  Call, // arg: procedure entry address
+  TailCall, // arg: procedure entry address; a Call whose caller returns right after it
+  Return,
+  Jump, // arg: target address
+  JumpUnless, // arg: target address, imm: predicate id
+  IterBegin, // imm: iteration count (always > 0)
+  IterNext, // arg: loop body address
+  Halt,
+
+  // Loop idioms, written over the head of a recognized WHILE loop by the optimizer.
+  // arg: loop exit address. The original loop body follows, so each one can
+  // fall back to behaving like the JumpUnless it replaced.
+  MoveToWall, // WHILE front-is-clear DO move
+  PickAll, // WHILE next-to-a-beeper DO pickbeeper
+  PutAll, // WHILE beeper-in-bag DO putbeeper
+}
+
+/**
+ * Whether an instruction is a step (a primitive or a custom instruction
+ * call) rather than a control instruction. Steps come first in OpCode.
+ */
+export function isStep(op: OpCode): boolean {
+  return op <= OpCode.TailCall;
+}
+
+/**
+ * Metadata about a compiled custom instruction.
+ */
+export interface ProcedureInfo {
+  name: string;
+  entry: number;
+  line: number;
+}
+
+/**
+ * A program lowered to a flat instruction array.
+ * Instructions are stored as parallel arrays indexed by address.
+ */
+export interface CompiledProgram {
+  /** Opcode of each instruction. */
+  ops: Uint8Array;
+  /** Resolved jump or call target. */
+  args: Int32Array;
+  /** Immediate operand: predicate id or iteration count. */
+  imm: Float64Array;
+  /** Source line of each instruction (1-based, 0 if synthetic). */
+  lines: Int32Array;
+  /** Compiled custom instructions. */
+  procedures: ProcedureInfo[];
+  /** Address of the first instruction of the execution block. */
+  entry: number;
+}
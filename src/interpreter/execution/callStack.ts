@@ -0,0 +1,108 @@
+/**
+ * Call stack storage and recursion reporting.
+ */
+
+import { CompiledProgram } from "@/interpreter/execution/bytecode";
+
+/**
+ * Default limit on nested custom instruction calls.
+ */
+export const DEFAULT_MAX_RECURSION_DEPTH = 1_000_000;
+
+/**
+ * Runs of identical calls shown at each end of a long recursion chain.
+ */
+const CHAIN_EDGE = 4;
+
+/**
+ * Growable stack of return addresses, one 32-bit slot per frame, so deep
+ * recursion costs 4 bytes per level.
+ */
+export class CallStack {
+  private frames: Int32Array = new Int32Array(64);
+  private depth: number = 0;
+
+  get length(): number {
+    return this.depth;
+  }
+
+  push(returnAddress: number): void {
+    if (this.depth === this.frames.length) {
+      const grown = new Int32Array(this.frames.length * 2);
+      grown.set(this.frames);
+      this.frames = grown;
+    }
+    this.frames[this.depth++] = returnAddress;
+  }
+
+  pop(): number {
+    return this.frames[--this.depth];
+  }
+
+  clear(): void {
+    this.depth = 0;
+  }
+
+  /**
+   * Copy of the live frames, outermost first.
+   */
+  toArray(): Int32Array {
+    return this.frames.slice(0, this.depth);
+  }
+
+  /**
+   * Replace the stack with saved frames (from toArray()).
+   */
+  load(frames: Int32Array): void {
+    if (frames.length > this.frames.length) {
+      this.frames = new Int32Array(frames.length);
+    }
+    this.frames.set(frames);
+    this.depth = frames.length;
+  }
+}
+
+/**
+ * Describe the custom instruction calls on a stack, outermost first, e.g.
+ * `climb (line 4) → step ×99999 (line 9)`. Runs of the same call are merged
+ * and long chains keep only their ends.
+ *
+ * @param returnAddresses - Return address of each frame; the call that
+ *   pushed it sits just before it
+ */
+export function formatCallChain(
+  program: CompiledProgram,
+  returnAddresses: ArrayLike<number>
+): string {
+  const names = new Map(program.procedures.map((p) => [p.entry, p.name]));
+  const runs: { call: number; count: number }[] = [];
+
+  for (let i = 0; i < returnAddresses.length; i++) {
+    const call = returnAddresses[i] - 1;
+    const last = runs[runs.length - 1];
+    if (
+      last &&
+      program.args[last.call] === program.args[call] &&
+      program.lines[last.call] === program.lines[call]
+    ) {
+      last.count++;
+    } else {
+      runs.push({ call, count: 1 });
+    }
+  }
+
+  const describe = ({ call, count }: { call: number; count: number }) => {
+    const name = names.get(program.args[call]) ?? "?";
+    const times = count > 1 ? ` ×${count}` : "";
+    return `${name}${times} (line ${program.lines[call]})`;
+  };
+
+  if (runs.length <= CHAIN_EDGE * 2) {
+    return runs.map(describe).join(" → ");
+  }
+  return [
+    ...runs.slice(0, CHAIN_EDGE).map(describe),
+    "…",
+    ...runs.slice(-CHAIN_EDGE).map(describe),
+  ].join(" → ");
+}
@@ -0,0 +1,491 @@
+/**
+ * JavaScript code generation: a faster tier for whole-program runs.
+ *
+ * A resolved program is turned into the source of a JavaScript function
+ * (custom instructions become nested functions, WHILE and ITERATE become
+ * native loops) and compiled with `new Function`, so V8 optimizes it like
+ * any other hot code.
+ *
+ * The program is first rewritten by optimizeAst(), which folds away
+ * primitive dispatches but keeps their weights. The generated code counts
+ * steps exactly like the VM. It also counts VM
+ * instructions as if no tail calls were eliminated, so its control count
+ * (instructions that are not steps) is never less than the VM's own: a run
+ * that stays within the budget here would stay within it on the VM too.
+ * Whenever that cannot be guaranteed (budget used up, or asked to stop), the
+ * run bails out and the caller re-runs the program on the VM, which then
+ * pauses or reports exactly what it always would.
+ *
+ * Time-sliced runs use a second, resumable variant instead: every function
+ * is a generator, and where the plain variant bails out when asked to stop
+ * it yields, so the run can carry on in the next slice.
+ *
+ * Infinite loops bail out early too. Without recursion, a run that never ends
+ * has a WHILE loop that iterates forever within one activation, and each of its
+ * iterations depends only on the world. So every WHILE activation runs its own
+ * cycle detection on the world hash at its back edge (sampled), and the first
+ * repeat hands the run to the VM, which finds the loop and reports its lines.
+ */
+
+import {
+  ASTNode,
+  ProgramNode,
+  WhileNode,
+  InstructionCallNode,
+  DefineInstructionNode,
+} from "@/interpreter/types/ast";
+import { BuiltIn, Predicate } from "@/interpreter/parsing/constants";
+import { World } from "@/interpreter/world";
+import { ExecutionBudget } from "@/interpreter/execution/budget";
+import { HashLane, combineLanes } from "@/interpreter/storage/stateHash";
+import { optimizeAst } from "@/interpreter/execution/astOptimizer";
+
+/**
+ * How a generated run ended.
+ * - completed: the execution block finished or turnoff ran
+ * - error: a world primitive failed (message and line are set)
+ * - bailout: the budget ran out, the world state repeated in a loop or the
+ *   run was stopped; the world was changed and must be restored before
+ *   running on the VM
+ */
+export interface GeneratedRunResult {
+  status: "completed" | "error" | "bailout";
+  turnedOff: boolean;
+  steps: number;
+  iterations: number;
+  /** Line of the last step. */
+  line: number;
+  message?: string;
+}
+
+/**
+ * How far a suspended run has got.
+ */
+export type GeneratedRunProgress = Pick<GeneratedRunResult, "steps" | "iterations" | "line">;
+
+/**
+ * A program compiled to JavaScript.
+ */
+export interface GeneratedProgram {
+  /** Deepest nesting of custom instruction calls the program can reach. */
+  readonly maxDepth: number;
+  /**
+   * Run the program on a world.
+   * @param budget - Step and control instruction limits
+   * @param stop - Polled at loop back edges and calls; true bails out
+   */
+  run(world: World, budget: ExecutionBudget, stop: () => boolean): GeneratedRunResult;
+  /**
+   * Start a run that can be suspended (JavaScript tier only): whenever `stop`
+   * returns true the iterator yields the progress so far, and next() carries
+   * on from there. It returns the result of the run like run() does, except
+   * that stopping never bails out.
+   */
+  start?(
+    world: World,
+    budget: ExecutionBudget,
+    stop: () => boolean
+  ): Iterator<GeneratedRunProgress, GeneratedRunResult>;
+}
+
+type Factory<T> = (
+  world: World,
+  maxSteps: number,
+  maxControl: number,
+  stop: () => boolean,
+  state: () => number,
+  halt: object,
+  bail: object
+) => T;
+
+/**
+ * Back edges and calls between two polls of the stop callback.
+ */
+const STOP_POLL_MASK = 1023;
+
+/**
+ * WHILE iterations between two world hashes of the cycle check. Any stride
+ * finds every cycle (the sampled states cycle too); hashing only some of them
+ * keeps tight loops fast.
+ */
+const CYCLE_SAMPLE_MASK = 15;
+
+// Thrown by generated code to unwind from any depth: turnoff, and bailing out
+const HALT = {};
+const BAIL = {};
+
+/**
+ * Statement emitted for each built-in (after the step has been counted).
+ */
+const BUILT_IN_CODE: Record<BuiltIn, string> = {
+  [BuiltIn.Move]: "w.move();",
+  [BuiltIn.TurnLeft]: "w.turnLeft();",
+  [BuiltIn.PickBeeper]: "w.pickBeeper();",
+  [BuiltIn.PutBeeper]: "w.putBeeper();",
+  [BuiltIn.TurnOff]: "throw HALT;",
+};
+
+/**
+ * WHILE loops the VM collapses into one bulk operation (see optimizeLoopIdioms),
+ * by the built-in that makes up their body: the condition that guards it.
+ */
+const LOOP_IDIOM_PREDICATES: Partial<Record<BuiltIn, Predicate>> = {
+  [BuiltIn.Move]: Predicate.FrontIsClear,
+  [BuiltIn.PickBeeper]: Predicate.NextToABeeper,
+  [BuiltIn.PutBeeper]: Predicate.BeeperInBag,
+};
+
+/**
+ * Code for each loop idiom: how many iterations remain, and the call that
+ * runs them all.
+ */
+const LOOP_IDIOM_CODE: Partial<Record<BuiltIn, { count: string; run: string }>> = {
+  [BuiltIn.Move]: { count: "w.distanceToWall()", run: "w.moveForward(n);" },
+  [BuiltIn.PickBeeper]: { count: "w.beepersAtKarel()", run: "w.pickAllBeepers();" },
+  [BuiltIn.PutBeeper]: { count: "w.karel.beepersInBag", run: "w.putAllBeepers();" },
+};
+
+/**
+ * The body of a WHILE loop the VM collapses, or null for any other loop.
+ */
+export function loopIdiom(node: WhileNode): { call: InstructionCallNode; builtIn: BuiltIn } | null {
+  const body = node.body.statements;
+  const [first] = body;
+  if (body.length !== 1 || first.type !== "call" || first.target?.kind !== "builtin") {
+    return null;
+  }
+  const builtIn = first.target.builtIn;
+  return LOOP_IDIOM_PREDICATES[builtIn] === node.predicate ? { call: first, builtIn } : null;
+}
+
+/**
+ * Compile a program whose calls have been bound by resolveCalls().
+ * Returns null for recursive programs: they need the VM's own call stack,
+ * which is far deeper than the JavaScript one.
+ */
+export function generateProgram(ast: ProgramNode): GeneratedProgram | null {
+  const maxDepth = callDepth(ast);
+  if (maxDepth === null) {
+    return null;
+  }
+
+  const optimized = optimizeAst(ast);
+  const factory = compile<GeneratedRunResult>(new Generator(false).generate(optimized));
+  let resumable: Factory<Iterator<GeneratedRunProgress, GeneratedRunResult>> | null = null;
+  const stateOf = (world: World) => () =>
+    combineLanes(world.stateHash(HashLane.Lo), world.stateHash(HashLane.Hi));
+
+  return {
+    maxDepth,
+    run: (world, budget, stop) =>
+      factory(world, budget.steps, budget.control, stop, stateOf(world), HALT, BAIL),
+    start: (world, budget, stop) => {
+      // Compiled on first use: only time-sliced runs need it
+      resumable ??= compile(new Generator(true).generate(optimized));
+      return resumable(world, budget.steps, budget.control, stop, stateOf(world), HALT, BAIL);
+    },
+  };
+}
+
+function compile<T>(source: string): Factory<T> {
+  return new Function(
+    "w",
+    "maxSteps",
+    "maxControl",
+    "stop",
+    "state",
+    "HALT",
+    "BAIL",
+    source
+  ) as Factory<T>;
+}
+
+/**
+ * Longest chain of nested custom instruction calls, or null if any
+ * instruction can reach itself.
+ */
+export function callDepth(ast: ProgramNode): number | null {
+  const callees = ast.definitions.map((def) => {
+    const found = new Set<number>();
+    collectCalls(def.body.statements, found);
+    return [...found];
+  });
+  const roots = new Set<number>();
+  collectCalls(ast.execution.statements, roots);
+
+  const depth: (number | undefined)[] = [];
+  const visiting = new Set<number>();
+  const visit = (index: number): number | null => {
+    if (visiting.has(index)) {
+      return null;
+    }
+    const known = depth[index];
+    if (known !== undefined) {
+      return known;
+    }
+    visiting.add(index);
+    let deepest = 0;
+    for (const callee of callees[index]) {
+      const d = visit(callee);
+      if (d === null) {
+        return null;
+      }
+      deepest = Math.max(deepest, d);
+    }
+    visiting.delete(index);
+    depth[index] = deepest + 1;
+    return deepest + 1;
+  };
+
+  let max = 0;
+  for (const root of roots) {
+    const d = visit(root);
+    if (d === null) {
+      return null;
+    }
+    max = Math.max(max, d);
+  }
+  return max;
+}
+
+function collectCalls(statements: ASTNode[], found: Set<number>): void {
+  for (const node of statements) {
+    switch (node.type) {
+      case "call":
+        if (node.target?.kind === "procedure") {
+          found.add(node.target.index);
+        }
+        break;
+      case "if":
+        collectCalls(node.thenBranch.statements, found);
+        if (node.elseBranch) {
+          collectCalls(node.elseBranch.statements, found);
+        }
+        break;
+      case "while":
+      case "iterate":
+        collectCalls(node.body.statements, found);
+        break;
+      case "block":
+        collectCalls(node.statements, found);
+        break;
+    }
+  }
+}
+
+/**
+ * Writes the body of the generated function.
+ *
+ * `it` counts VM instructions with the same costs the compiler's layout has:
+ * one per primitive, call, return, branch, jump and loop counter update.
+ * `steps` counts the primitives and calls among them.
+ */
+class Generator {
+  private out: string[] = [];
+  private indent: string = "";
+  private loopDepth: number = 0;
+  private whileLoops: number = 0;
+
+  /**
+   * @param resumable - Emit generator functions that yield when asked to stop,
+   *   instead of plain functions that bail out
+   */
+  constructor(private readonly resumable: boolean) {}
+
+  generate(ast: ProgramNode): string {
+    this.out = [];
+    if (this.resumable) {
+      this.line("return (function* () {");
+      this.nested(() => this.body(ast));
+      this.line("})();");
+    } else {
+      this.body(ast);
+    }
+    return this.out.join("\n");
+  }
+
+  private body(ast: ProgramNode): void {
+    this.line("let it = 0, steps = 0, line = 0, polls = 0;");
+    this.line("const over = () => steps > maxSteps || it - steps > maxControl;");
+    this.line("const check = () => {");
+    this.line("  if (over()) throw BAIL;");
+    this.line(`  return (++polls & ${STOP_POLL_MASK}) === 0 && stop();`);
+    this.line("};");
+
+    ast.definitions.forEach((def, index) => this.procedure(def, index));
+
+    this.line("let turnedOff = false;");
+    this.line("try {");
+    this.nested(() => {
+      this.statements(ast.execution.statements);
+      this.line("it++;"); // Halt
+    });
+    this.line("} catch (e) {");
+    this.nested(() => {
+      this.line("if (e === BAIL || over()) {");
+      this.line('  return { status: "bailout", turnedOff, steps, iterations: it, line };');
+      this.line("}");
+      this.line("if (e !== HALT) {");
+      this.line("  if (!(e instanceof Error)) throw e;");
+      this.line(
+        '  return { status: "error", turnedOff, steps, iterations: it, line, message: e.message };'
+      );
+      this.line("}");
+      this.line("turnedOff = true;");
+    });
+    this.line("}");
+    this.line("if (over()) {");
+    this.line('  return { status: "bailout", turnedOff, steps, iterations: it, line };');
+    this.line("}");
+    this.line('return { status: "completed", turnedOff, steps, iterations: it, line };');
+  }
+
+  /**
+   * Poll for the budget and the stop callback (at back edges and calls).
+   */
+  private check(): void {
+    if (this.resumable) {
+      this.line("if (check()) yield { steps, iterations: it, line };");
+    } else {
+      this.line("if (check()) throw BAIL;");
+    }
+  }
+
+  private procedure(def: DefineInstructionNode, index: number): void {
+    this.line(`function${this.resumable ? "*" : ""} p${index}() {`);
+    this.nested(() => {
+      this.check();
+      this.statements(def.body.statements);
+      this.line("it++;"); // Return
+    });
+    this.line("}");
+  }
+
+  private statements(statements: ASTNode[]): void {
+    for (const node of statements) {
+      this.statement(node);
+    }
+  }
+
+  private statement(node: ASTNode): void {
+    switch (node.type) {
+      case "call":
+        this.call(node);
+        break;
+      case "if":
+        this.line(`it++;`);
+        this.line(`if (w.evaluatePredicate(${node.predicate})) {`);
+        this.nested(() => {
+          this.statements(node.thenBranch.statements);
+          if (node.elseBranch) {
+            this.line("it++;"); // Jump over the else branch
+          }
+        });
+        if (node.elseBranch) {
+          const elseBranch = node.elseBranch;
+          this.line("} else {");
+          this.nested(() => this.statements(elseBranch.statements));
+        }
+        this.line("}");
+        break;
+      case "while":
+        this.whileLoop(node);
+        break;
+      case "iterate": {
+        if (node.count <= 0) {
+          break;
+        }
+        const counter = `i${this.loopDepth++}`;
+        this.line("it++;"); // IterBegin
+        this.line(`for (let ${counter} = ${node.count}; ${counter} > 0; ${counter}--) {`);
+        this.nested(() => {
+          this.statements(node.body.statements);
+          this.line("it++;"); // IterNext
+          this.check();
+        });
+        this.line("}");
+        this.loopDepth--;
+        break;
+      }
+      case "block":
+        this.statements(node.statements);
+        break;
+      case "folded":
+        this.line(`it += ${node.iterations};`);
+        if (node.steps > 0) {
+          this.line(`steps += ${node.steps}; line = ${node.line};`);
+        }
+        if (node.turns > 0) {
+          this.line(`w.turnLeft(${node.turns % 4});`);
+        }
+        break;
+    }
+  }
+
+  private call(node: InstructionCallNode): void {
+    const target = node.target;
+    if (!target) {
+      throw new Error(`Unresolved instruction: ${node.name}`);
+    }
+    this.line(`it++; steps++; line = ${node.line};`);
+    if (target.kind === "builtin") {
+      this.line(BUILT_IN_CODE[target.builtIn]);
+    } else {
+      this.line(`${this.resumable ? "yield* " : ""}p${target.index}();`);
+    }
+  }
+
+  private whileLoop(node: WhileNode): void {
+    const match = loopIdiom(node);
+    const idiom = match && LOOP_IDIOM_CODE[match.builtIn];
+
+    if (match && idiom) {
+      // Per iteration: branch, body and back jump; plus the final branch
+      this.line("{");
+      this.nested(() => {
+        this.line(`const n = ${idiom.count};`);
+        this.line("it += n * 3 + 1;");
+        this.line("if (n > 0) {");
+        this.line(`  steps += n; line = ${match.call.line};`);
+        this.line(`  ${idiom.run}`);
+        this.line("}");
+        this.check();
+      });
+      this.line("}");
+      return;
+    }
+
+    // Brent's cycle detection (see CycleDetector) over this activation's
+    // sampled world states: saved hash, next power of two, checks since
+    // saving, iterations
+    const k = this.whileLoops++;
+    this.line(`let s${k} = NaN, pow${k} = 1, n${k} = 0, c${k} = 0;`);
+    this.line("while (true) {");
+    this.nested(() => {
+      this.line("it++;"); // JumpUnless
+      this.line(`if (!w.evaluatePredicate(${node.predicate})) break;`);
+      this.statements(node.body.statements);
+      this.line("it++;"); // Jump back
+      this.check();
+      this.line(`if ((++c${k} & ${CYCLE_SAMPLE_MASK}) === 0) {`);
+      this.line(`  const h${k} = state();`);
+      this.line(`  if (h${k} === s${k}) throw BAIL;`);
+      this.line(`  if (++n${k} === pow${k}) {`);
+      this.line(`    s${k} = h${k}; pow${k} *= 2; n${k} = 0;`);
+      this.line("  }");
+      this.line("}");
+    });
+    this.line("}");
+  }
+
+  private nested(emit: () => void): void {
+    const saved = this.indent;
+    this.indent += "  ";
+    emit();
+    this.indent = saved;
+  }
+
+  private line(code: string): void {
+    this.out.push(this.indent + code);
+  }
+}
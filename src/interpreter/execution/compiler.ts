@@ -0,0 +1,200 @@
+/**
+ * Compiler from the Karel AST to VM bytecode.
+ */
+
+import {
+  ASTNode,
+  ProgramNode,
+  IfNode,
+  WhileNode,
+  IterateNode,
+  InstructionCallNode,
+} from "@/interpreter/types/ast";
+import { Diagnostic } from "@/interpreter/types/errors";
+import { BuiltIn } from "@/interpreter/parsing/constants";
+import { Parser } from "@/interpreter/parsing/parser";
+import { ErrorMessages } from "@/i18n/messages";
+import { OpCode, CompiledProgram, ProcedureInfo } from "@/interpreter/execution/bytecode";
+import { resolveCalls } from "@/interpreter/execution/resolver";
+import { optimizeLoopIdioms, optimizeTailCalls } from "@/interpreter/execution/optimizer";
+
+/**
+ * Opcode of each built-in instruction.
+ */
+const BUILT_IN_OPCODES: Record<BuiltIn, OpCode> = {
+  [BuiltIn.Move]: OpCode.Move,
+  [BuiltIn.TurnLeft]: OpCode.TurnLeft,
+  [BuiltIn.PickBeeper]: OpCode.PickBeeper,
+  [BuiltIn.PutBeeper]: OpCode.PutBeeper,
+  [BuiltIn.TurnOff]: OpCode.TurnOff,
+};
+
+/**
+ * Parse, resolve, compile and optimize a program.
+ * The program is null if it did not parse or calls an unknown instruction;
+ * otherwise the resolved AST is returned with it.
+ */
+export function compileSource(source: string): {
+  program: CompiledProgram | null;
+  ast: ProgramNode | null;
+  diagnostics: Diagnostic[];
+} {
+  const { ast, diagnostics } = new Parser().parse(source);
+  if (!ast) {
+    return { program: null, ast: null, diagnostics };
+  }
+
+  const unresolved = resolveCalls(ast);
+  for (const call of unresolved) {
+    // The parser already reports calls it cannot see a definition for
+    const message = ErrorMessages.unknownInstruction(call.name, call.line);
+    if (!diagnostics.some((d) => d.message === message)) {
+      diagnostics.push({ message, line: call.line, column: 0, severity: "error" });
+    }
+  }
+  if (unresolved.length > 0) {
+    return { program: null, ast: null, diagnostics };
+  }
+
+  const program = new Compiler().compile(ast);
+  return { program: optimizeTailCalls(optimizeLoopIdioms(program)), ast, diagnostics };
+}
+
+/**
+ * Lowers a parsed program into a flat instruction array.
+ * Jump offsets and call targets are resolved at compile time; instruction
+ * calls must already be bound by resolveCalls().
+ */
+export class Compiler {
+  private ops: OpCode[] = [];
+  private args: number[] = [];
+  private imm: number[] = [];
+  private lines: number[] = [];
+  private callFixups: { address: number; procedure: number }[] = [];
+
+  compile(ast: ProgramNode): CompiledProgram {
+    this.ops = [];
+    this.args = [];
+    this.imm = [];
+    this.lines = [];
+    this.callFixups = [];
+
+    const procedures: ProcedureInfo[] = ast.definitions.map((def) => ({
+      name: def.name,
+      entry: -1,
+      line: def.line,
+    }));
+
+    // Execution block comes first, followed by each procedure body
+    const entry = this.ops.length;
+    this.compileStatements(ast.execution.statements);
+    this.emit(OpCode.Halt, 0);
+
+    ast.definitions.forEach((def, index) => {
+      procedures[index].entry = this.ops.length;
+      this.compileStatements(def.body.statements);
+      this.emit(OpCode.Return, def.line);
+    });
+
+    for (const fixup of this.callFixups) {
+      this.args[fixup.address] = procedures[fixup.procedure].entry;
+    }
+
+    return {
+      ops: Uint8Array.from(this.ops),
+      args: Int32Array.from(this.args),
+      imm: Float64Array.from(this.imm),
+      lines: Int32Array.from(this.lines),
+      procedures,
+      entry,
+    };
+  }
+
+  private compileStatements(statements: ASTNode[]): void {
+    for (const statement of statements) {
+      this.compileStatement(statement);
+    }
+  }
+
+  private compileStatement(node: ASTNode): void {
+    switch (node.type) {
+      case "call":
+        this.compileCall(node);
+        break;
+      case "if":
+        this.compileIf(node);
+        break;
+      case "while":
+        this.compileWhile(node);
+        break;
+      case "iterate":
+        this.compileIterate(node);
+        break;
+      case "block":
+        this.compileStatements(node.statements);
+        break;
+    }
+  }
+
+  private compileCall(node: InstructionCallNode): void {
+    const target = node.target;
+    if (!target) {
+      throw new Error(`Unresolved instruction: ${node.name}`);
+    }
+
+    if (target.kind === "builtin") {
+      this.emit(BUILT_IN_OPCODES[target.builtIn], node.line);
+      return;
+    }
+
+    const address = this.emit(OpCode.Call, node.line);
+    this.callFixups.push({ address, procedure: target.index });
+  }
+
+  private compileIf(node: IfNode): void {
+    const branch = this.emit(OpCode.JumpUnless, node.line, 0, node.predicate);
+    this.compileStatements(node.thenBranch.statements);
+
+    if (node.elseBranch) {
+      const skipElse = this.emit(OpCode.Jump, node.line);
+      this.patch(branch, this.ops.length);
+      this.compileStatements(node.elseBranch.statements);
+      this.patch(skipElse, this.ops.length);
+    } else {
+      this.patch(branch, this.ops.length);
+    }
+  }
+
+  private compileWhile(node: WhileNode): void {
+    const top = this.ops.length;
+    const exit = this.emit(OpCode.JumpUnless, node.line, 0, node.predicate);
+    this.compileStatements(node.body.statements);
+    this.emit(OpCode.Jump, node.line, top);
+    this.patch(exit, this.ops.length);
+  }
+
+  private compileIterate(node: IterateNode): void {
+    if (node.count <= 0) {
+      return;
+    }
+    this.emit(OpCode.IterBegin, node.line, 0, node.count);
+    const body = this.ops.length;
+    this.compileStatements(node.body.statements);
+    this.emit(OpCode.IterNext, node.line, body);
+  }
+
+  /**
+   * Append an instruction and return its address.
+   */
+  private emit(op: OpCode, line: number, arg: number = 0, imm: number = 0): number {
+    this.ops.push(op);
+    this.args.push(arg);
+    this.imm.push(imm);
+    this.lines.push(line);
+    return this.ops.length - 1;
+  }
+
+  private patch(address: number, target: number): void {
+    this.args[address] = target;
+  }
+}
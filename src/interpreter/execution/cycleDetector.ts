@@ -0,0 +1,42 @@
+/**
+ * Cycle detection over a stream of state hashes.
+ */
+
+/**
+ * Brent's cycle detection: keeps a single saved state and compares every new
+ * state against it, moving the saved state forward at powers of two.
+ *
+ * Memory is constant. For a run that enters a cycle of length λ after μ checks,
+ * the cycle is found within about 2 * max(μ, λ) + λ checks.
+ */
+export class CycleDetector {
+  private saved: number = NaN;
+  private power: number = 1;
+  private length: number = 0;
+
+  /**
+   * Forget all previous states.
+   */
+  reset(): void {
+    this.saved = NaN;
+    this.power = 1;
+    this.length = 0;
+  }
+
+  /**
+   * Record a state. Returns the cycle length (in checks) if this state was
+   * seen before, or 0 otherwise.
+   */
+  check(state: number): number {
+    this.length++;
+    if (state === this.saved) {
+      return this.length;
+    }
+    if (this.length === this.power) {
+      this.saved = state;
+      this.power *= 2;
+      this.length = 0;
+    }
+    return 0;
+  }
+}
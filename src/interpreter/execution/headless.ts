@@ -0,0 +1,127 @@
+/**
+ * Headless program execution (no VS Code, no animation).
+ */
+
+import { World, KarelMap } from "@/interpreter/world";
+import { Interpreter, ExecutionTier } from "@/interpreter/execution/interpreter";
+import { RuntimeError, Diagnostic } from "@/interpreter/types/errors";
+import { TraceRecorder, TraceStatus } from "@/interpreter/execution/trace";
+import { ExecutionBudget } from "@/interpreter/execution/budget";
+
+/**
+ * Outcome of a headless run.
+ * - completed: the program finished normally
+ * - error: a runtime error stopped it
+ * - paused: it used up its step or control budget before finishing
+ * - invalid: the program did not parse
+ */
+export type HeadlessStatus = "completed" | "error" | "paused" | "invalid";
+
+export interface HeadlessResult {
+  status: HeadlessStatus;
+  /** Steps executed (primitives and custom instruction calls). */
+  steps: number;
+  /** Engine that ran the program ("vm" when a compiled tier fell back to it). */
+  tier: ExecutionTier;
+  /** Wall-clock time of parsing plus execution in milliseconds. */
+  timeMs: number;
+  /** Final world state. */
+  world: KarelMap;
+  /** Runtime error when status is "error", or which budget ran out when it is "paused". */
+  error?: { message: string; line?: number };
+  /** Parser errors, when status is "invalid". */
+  diagnostics?: Diagnostic[];
+  /** Encoded execution trace, when requested and the program parsed. */
+  trace?: Uint8Array;
+}
+
+export interface HeadlessOptions {
+  /** Record an execution trace (.kltrace) of the run. */
+  trace?: boolean;
+  /** Limit on nested custom instruction calls (DEFAULT_MAX_RECURSION_DEPTH if unset). */
+  maxRecursionDepth?: number;
+  /** Engine to run the program on ("js" if unset). */
+  tier?: ExecutionTier;
+  /** Step and control limits (DEFAULT_EXECUTION_BUDGET for those unset). */
+  budget?: Partial<ExecutionBudget>;
+}
+
+/**
+ * Parse and run a program on a map at full speed.
+ */
+export function runHeadless(
+  source: string,
+  map: KarelMap,
+  options: HeadlessOptions = {}
+): HeadlessResult {
+  const start = performance.now();
+  const world = World.fromJSON(map);
+  const interpreter = new Interpreter(world);
+  const trace = options.trace ? new TraceRecorder(world.toJSON()) : null;
+  interpreter.setTrace(trace);
+  if (options.maxRecursionDepth !== undefined) {
+    interpreter.setMaxRecursionDepth(options.maxRecursionDepth);
+  }
+  if (options.tier !== undefined) {
+    interpreter.setTier(options.tier);
+  }
+  if (options.budget !== undefined) {
+    interpreter.setBudget(options.budget);
+  }
+
+  const diagnostics = interpreter.load(source);
+  const errors = diagnostics.filter((d) => d.severity === "error");
+  if (errors.length > 0) {
+    return {
+      status: "invalid",
+      steps: 0,
+      tier: "vm",
+      timeMs: performance.now() - start,
+      world: world.toJSON(),
+      diagnostics: errors,
+    };
+  }
+
+  try {
+    interpreter.runHeadless();
+  } catch (e) {
+    if (!(e instanceof RuntimeError)) {
+      throw e;
+    }
+    trace?.finish(TraceStatus.Error, e.line, e.message);
+    return {
+      status: "error",
+      steps: interpreter.getStepCount(),
+      tier: interpreter.getExecutedTier(),
+      timeMs: performance.now() - start,
+      world: world.toJSON(),
+      error: { message: e.message, line: e.line },
+      trace: trace?.toBytes(),
+    };
+  }
+
+  const pause = interpreter.getPauseMessage();
+  if (pause !== null) {
+    const line = interpreter.getCurrentLine();
+    trace?.finish(TraceStatus.Stopped, line, pause);
+    return {
+      status: "paused",
+      steps: interpreter.getStepCount(),
+      tier: interpreter.getExecutedTier(),
+      timeMs: performance.now() - start,
+      world: world.toJSON(),
+      error: { message: pause },
+      trace: trace?.toBytes(),
+    };
+  }
+
+  trace?.finish(TraceStatus.Completed);
+  return {
+    status: "completed",
+    steps: interpreter.getStepCount(),
+    tier: interpreter.getExecutedTier(),
+    timeMs: performance.now() - start,
+    world: world.toJSON(),
+    trace: trace?.toBytes(),
+  };
+}
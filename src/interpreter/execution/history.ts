@@ -0,0 +1,123 @@
+/**
+ * Execution history for reverse stepping and seeking.
+ */
+
+import type { WorldSnapshot } from "@/interpreter/world";
+
+/**
+ * Full VM and world state after `step` steps.
+ */
+export interface Checkpoint {
+  step: number;
+  pc: number;
+  callStack: Int32Array;
+  counters: number[];
+  stackHash: Uint32Array;
+  controlCount: number;
+  currentLine: number;
+  world: WorldSnapshot;
+}
+
+/**
+ * Steps between checkpoints of a new history.
+ */
+const DEFAULT_INTERVAL = 1000;
+
+/**
+ * Checkpoints kept before every other one is dropped.
+ */
+const MAX_CHECKPOINTS = 256;
+
+/**
+ * Longest interval between checkpoints: seeking to a step re-executes at most
+ * this many steps (after the latest checkpoint, everything back to the
+ * oldest one kept).
+ */
+const MAX_INTERVAL = 64_000;
+
+/**
+ * Call stack frames kept across all checkpoints before every other one is
+ * dropped, so deep recursion cannot make the history grow without bound.
+ */
+const MAX_STORED_FRAMES = 4_000_000;
+
+/**
+ * Periodic checkpoints of a run. Programs are deterministic, so the steps
+ * between two checkpoints are not stored: they are re-executed from the
+ * earlier one when needed.
+ *
+ * Memory stays bounded on long runs: when the list is full (or holds too
+ * many call frames), every other checkpoint is dropped and the interval
+ * doubles. Once the interval reaches MAX_INTERVAL the oldest checkpoints are
+ * dropped instead, except the one at the start: stepping back stays cheap on
+ * any run, and only seeking further back than the kept window replays from
+ * the start.
+ */
+export class ExecutionHistory {
+  private checkpoints: Checkpoint[] = [];
+  private storedFrames: number = 0;
+  private readonly baseInterval: number;
+  private interval: number;
+
+  constructor(interval: number = DEFAULT_INTERVAL) {
+    this.baseInterval = interval;
+    this.interval = interval;
+  }
+
+  /**
+   * Step count at which the next checkpoint is due.
+   */
+  get nextCheckpointStep(): number {
+    const last = this.checkpoints[this.checkpoints.length - 1];
+    return last ? last.step + this.interval : 0;
+  }
+
+  /**
+   * Add a checkpoint later than every existing one.
+   */
+  add(checkpoint: Checkpoint): void {
+    this.checkpoints.push(checkpoint);
+    this.storedFrames += checkpoint.callStack.length;
+    while (
+      this.checkpoints.length > MAX_CHECKPOINTS ||
+      (this.storedFrames > MAX_STORED_FRAMES && this.checkpoints.length > 1)
+    ) {
+      if (this.interval < MAX_INTERVAL) {
+        this.checkpoints = this.checkpoints.filter((_, i) => i % 2 === 0);
+        this.storedFrames = this.checkpoints.reduce((sum, c) => sum + c.callStack.length, 0);
+        this.interval *= 2;
+      } else {
+        const [dropped] = this.checkpoints.splice(1, 1);
+        this.storedFrames -= dropped.callStack.length;
+      }
+    }
+  }
+
+  /**
+   * Latest checkpoint at or before a step, or null if there is none.
+   */
+  find(step: number): Checkpoint | null {
+    let lo = 0;
+    let hi = this.checkpoints.length - 1;
+    let found: Checkpoint | null = null;
+    while (lo <= hi) {
+      const mid = (lo + hi) >>> 1;
+      if (this.checkpoints[mid].step <= step) {
+        found = this.checkpoints[mid];
+        lo = mid + 1;
+      } else {
+        hi = mid - 1;
+      }
+    }
+    return found;
+  }
+
+  /**
+   * Forget every checkpoint (the run starts over).
+   */
+  clear(): void {
+    this.checkpoints = [];
+    this.storedFrames = 0;
+    this.interval = this.baseInterval;
+  }
+}
@@ -2,35 +2,113 @@
  * Interpreter for executing Karel programs.
  */
 
-import { World } from "@/interpreter/world";
-import { ProgramNode, BlockNode, InstructionCallNode } from "@/interpreter/types/ast";
+import { World, WorldSnapshot } from "@/interpreter/world";
 import { RuntimeError, Diagnostic } from "@/interpreter/types/errors";
 import { ErrorMessages } from "@/i18n/messages";
-import { Parser } from "@/interpreter/parsing/parser";
-import { ExecutionFrame } from "@/interpreter/execution/executionFrame";
+import { compileSource } from "@/interpreter/execution/compiler";
+import {
+  generateProgram,
+  GeneratedProgram,
+  GeneratedRunProgress,
+  GeneratedRunResult,
+} from "@/interpreter/execution/codegen";
+import { generateWasmProgram } from "@/interpreter/execution/wasm";
+import { ProgramNode } from "@/interpreter/types/ast";
+import { OpCode, CompiledProgram, isStep } from "@/interpreter/execution/bytecode";
+import { CycleDetector } from "@/interpreter/execution/cycleDetector";
+import { TraceRecorder, TraceOp } from "@/interpreter/execution/trace";
+import { ExecutionHistory, Checkpoint } from "@/interpreter/execution/history";
+import {
+  CallStack,
+  DEFAULT_MAX_RECURSION_DEPTH,
+  formatCallChain,
+} from "@/interpreter/execution/callStack";
+import {
+  ExecutionBudget,
+  BudgetKind,
+  DEFAULT_EXECUTION_BUDGET,
+  normalizeBudget,
+  budgetExhaustedMessage,
+} from "@/interpreter/execution/budget";
+import { HashKind, HashLane, hashKey, combineLanes } from "@/interpreter/storage/stateHash";
+
+/**
+ * Time budget of one turbo slice before yielding to the event loop.
+ */
+const TURBO_SLICE_MS = 8;
+
+/**
+ * Steps executed between clock reads in turbo mode.
+ */
+const TURBO_CHECK_INTERVAL = 256;
+
+/**
+ * Engine that runs whole programs (headless and turbo runs):
+ * - vm: the bytecode interpreter alone
+ * - js: compiled to JavaScript, falling back to the VM (the default)
+ * - wasm: compiled to WebAssembly, falling back to the VM; experimental, and
+ *   turbo runs use js instead since a WebAssembly run cannot be interrupted
+ */
+export type ExecutionTier = "vm" | "js" | "wasm";
 
 /**
  * Interpreter for executing Karel programs.
  */
 export class Interpreter {
   private world: World;
+  private program: CompiledProgram | null = null;
   private ast: ProgramNode | null = null;
-  private customInstructions: Map<string, BlockNode> = new Map();
+  private generated: Map<ExecutionTier, GeneratedProgram | null> = new Map(); // null if unsupported
+  private tier: ExecutionTier = "js";
+  private executedTier: ExecutionTier = "vm";
   private running: boolean = false;
   private currentLine: number = 0;
   private executionSpeed: number = 500;
-  private maxIterations: number = 100000;
-  private iterationCount: number = 0;
+  private turbo: boolean = false;
+  private silent: boolean = false; // suppress onStep while running turbo slices
+  private budget: ExecutionBudget = { ...DEFAULT_EXECUTION_BUDGET };
+  private limits: ExecutionBudget = { ...DEFAULT_EXECUTION_BUDGET }; // budget plus extensions
+  private exhausted: BudgetKind | null = null; // paused because this budget ran out
+  private maxRecursionDepth: number = DEFAULT_MAX_RECURSION_DEPTH;
+  private controlCount: number = 0;
+  private stepCount: number = 0;
 
-  // Step execution state
-  private executionStack: ExecutionFrame[] = [];
+  // VM state
+  private pc: number = 0;
+  private callStack: CallStack = new CallStack();
+  private counters: number[] = [];
   private stepInitialized: boolean = false;
   private stepCompleted: boolean = false;
 
+  // Compiled turbo run between two slices (or stopped); the VM is still at the start
+  private suspended: {
+    run: Iterator<GeneratedRunProgress, GeneratedRunResult>;
+    before: WorldSnapshot;
+    wasModified: boolean;
+  } | null = null;
+  private sliceDeadline: number = 0; // the compiled run yields after this time
+
+  // Infinite loop detection
+  private cycleDetector: CycleDetector = new CycleDetector();
+  private stackHash: Uint32Array = new Uint32Array(2); // Zobrist hash of callStack and counters
+  private replay: { state: number; closed: boolean; lines: Set<number> } | null = null;
+
+  // Execution trace, if one is being recorded
+  private trace: TraceRecorder | null = null;
+
+  // Checkpoints for reverse stepping, if enabled
+  private history: ExecutionHistory | null = null;
+  private seeking: boolean = false; // re-executing steps from a checkpoint
+
   // Callbacks for UI updates
   public onStep?: (line: number) => void;
+  public onSlice?: (line: number) => void; // turbo mode: end of each time slice
   public onComplete?: () => void;
   public onError?: (error: RuntimeError) => void;
+  public onBudgetExhausted?: (message: string) => void; // paused; extendBudget() to go on
+
+  // Polled inside turbo batches so an external stop takes effect mid-batch
+  public interruptRequested?: () => boolean;
 
   constructor(world: World) {
     this.world = world;
@@ -51,30 +129,60 @@ export class Interpreter {
   }
 
   /**
-   * Load and parse a program.
+   * Number of steps (primitives and custom instruction calls) executed so far.
    */
-  load(source: string): Diagnostic[] {
-    const parser = new Parser();
-    const { ast, diagnostics } = parser.parse(source);
-    this.ast = ast;
+  getStepCount(): number {
+    return this.stepCount;
+  }
 
-    // Build custom instructions map
-    this.customInstructions.clear();
-    if (ast) {
-      for (const def of ast.definitions) {
-        this.customInstructions.set(def.name.toLowerCase(), def.body);
-      }
-    }
+  /**
+   * Line of the last step executed (0 before the first one).
+   */
+  getCurrentLine(): number {
+    return this.currentLine;
+  }
+
+  /**
+   * Why the run is paused, if it used up its budget (null otherwise).
+   */
+  getPauseMessage(): string | null {
+    const kind = this.exhausted;
+    return kind ? budgetExhaustedMessage(kind, this.limits[kind]) : null;
+  }
+
+  /**
+   * Record every primitive executed from now on into a trace (null to stop).
+   */
+  setTrace(trace: TraceRecorder | null): void {
+    this.trace = trace;
+  }
 
+  /**
+   * Keep periodic checkpoints of the run so seek() can go backwards.
+   */
+  enableHistory(): void {
+    this.history ??= new ExecutionHistory();
+  }
+
+  /**
+   * Load, parse and compile a program. Calls to unknown instructions are
+   * reported here, and leave no program loaded.
+   */
+  load(source: string): Diagnostic[] {
+    const { program, ast, diagnostics } = compileSource(source);
+    this.suspended = null;
+    this.program = program;
+    this.ast = ast;
+    this.generated.clear();
     return diagnostics;
   }
 
   /**
    * Run the entire program.
-   * Uses the same stack-based execution as step() for consistency.
+   * Uses the same VM loop as step() for consistency.
    */
   async run(): Promise<void> {
-    if (!this.ast) {
+    if (!this.program) {
       throw new RuntimeError(ErrorMessages.programNotLoaded());
     }
 
@@ -83,18 +191,14 @@ export class Interpreter {
       this.initializeStepMode();
     }
 
-    // Run all steps with delay
     try {
-      while (this.running && !this.stepCompleted) {
-        const hasMore = this.executeOneStep();
-        if (!hasMore) {
-          this.stepCompleted = true;
-          this.onComplete?.();
-          break;
-        }
-        // Wait for animation between steps
-        await this.delay();
+      if (this.turbo) {
+        await this.runSliced();
+      } else {
+        this.catchUpSuspended();
+        await this.runAnimated();
       }
+      this.reportPause();
     } catch (e) {
       this.stepCompleted = true;
       if (e instanceof RuntimeError) {
@@ -109,29 +213,280 @@ export class Interpreter {
     }
   }
 
+  /**
+   * Run the program to completion synchronously, without reporting steps.
+   * Runtime errors are thrown instead of being passed to onError, and a run
+   * that uses up its budget returns paused (see getPauseMessage()).
+   * Uses the selected compiled tier when the program allows it.
+   */
+  runHeadless(): void {
+    if (!this.program) {
+      throw new RuntimeError(ErrorMessages.programNotLoaded());
+    }
+    if (!this.stepInitialized) {
+      this.initializeStepMode();
+    }
+
+    this.catchUpSuspended();
+    this.silent = true;
+    try {
+      if (this.runGenerated(this.tier, () => false)) {
+        return;
+      }
+      while (this.executeOneStep() && !this.exhausted) {
+        // no per-step work when headless
+      }
+    } finally {
+      this.silent = false;
+      this.stepCompleted = !this.exhausted;
+    }
+  }
+
+  /**
+   * Run all steps with an animation delay after each one.
+   */
+  private async runAnimated(): Promise<void> {
+    while (this.running && !this.stepCompleted) {
+      const hasMore = this.executeOneStep();
+      if (!hasMore) {
+        this.stepCompleted = true;
+        this.onComplete?.();
+        break;
+      }
+      // Wait for animation between steps
+      await this.delay();
+    }
+  }
+
+  /**
+   * Run as many steps as fit in each time slice, then yield to the event loop.
+   * onStep is not reported; onSlice fires once per slice with the latest line.
+   */
+  private async runSliced(): Promise<void> {
+    let finished: boolean;
+    try {
+      finished = await this.runGeneratedSliced();
+    } finally {
+      this.onSlice?.(this.currentLine);
+    }
+    if (finished) {
+      this.onComplete?.();
+      return;
+    }
+    if (this.suspended) {
+      return; // stopped between two slices
+    }
+
+    while (this.running && !this.stepCompleted) {
+      const deadline = performance.now() + TURBO_SLICE_MS;
+      let hasMore: boolean;
+      this.silent = true;
+      try {
+        hasMore = this.runBatch(deadline);
+      } finally {
+        this.silent = false;
+        this.onSlice?.(this.currentLine);
+      }
+      if (!hasMore) {
+        this.stepCompleted = true;
+        this.onComplete?.();
+        break;
+      }
+      await yieldToEventLoop();
+    }
+  }
+
+  /**
+   * Run the program as resumable generated JavaScript, one time slice at a
+   * time. Returns true if the run finished there. Returns false when the VM
+   * must take over (see runGenerated()), and also when stopped: the run then
+   * stays suspended, and stepping, seeking or a run that is not time-sliced
+   * first catches the VM up with it.
+   */
+  private async runGeneratedSliced(): Promise<boolean> {
+    if (!this.suspended) {
+      const generated = this.prepareGenerated(this.tier === "vm" ? "vm" : "js");
+      if (!generated?.start) {
+        return false;
+      }
+      const before = this.world.captureState();
+      const wasModified = this.world.isModified;
+      const stop = () =>
+        performance.now() >= this.sliceDeadline || this.interruptRequested?.() === true;
+      const run = generated.start(this.world, this.limits, stop);
+      this.suspended = { run, before, wasModified };
+    }
+
+    const suspended = this.suspended;
+    while (this.running && this.suspended === suspended) {
+      this.sliceDeadline = performance.now() + TURBO_SLICE_MS;
+      const next = suspended.run.next();
+      if (next.done) {
+        this.suspended = null;
+        return this.finishGenerated("js", next.value, suspended.before, suspended.wasModified);
+      }
+
+      this.stepCount = next.value.steps;
+      this.controlCount = next.value.iterations - next.value.steps;
+      this.currentLine = next.value.line;
+      if (this.interruptRequested?.()) {
+        this.running = false;
+        break;
+      }
+      this.onSlice?.(this.currentLine);
+      await yieldToEventLoop();
+    }
+    return false; // stopped, or superseded while waiting (reset or load)
+  }
+
+  /**
+   * Bring the VM to where a suspended compiled run got: restore the world it
+   * started from and re-execute the same number of steps silently.
+   */
+  private catchUpSuspended(): void {
+    const suspended = this.suspended;
+    if (!suspended) {
+      return;
+    }
+    this.suspended = null;
+    const steps = this.stepCount;
+    this.world.loadState(suspended.before, suspended.wasModified);
+    this.stepCount = 0;
+    this.controlCount = 0;
+    this.currentLine = 0;
+
+    const silent = this.silent;
+    this.seeking = true;
+    this.silent = true;
+    try {
+      while (this.stepCount < steps && this.executeOneStep() && !this.exhausted) {
+        // the compiled run already got this far without an error
+      }
+    } finally {
+      this.seeking = false;
+      this.silent = silent;
+      this.cycleDetector.reset();
+    }
+  }
+
+  /**
+   * Execute steps until the deadline passes, the program ends or it is stopped.
+   * Returns false once the program has finished.
+   */
+  private runBatch(deadline: number): boolean {
+    while (this.running) {
+      for (let i = 0; i < TURBO_CHECK_INTERVAL; i++) {
+        if (!this.executeOneStep()) {
+          return false;
+        }
+      }
+      if (this.interruptRequested?.()) {
+        this.running = false;
+        break;
+      }
+      if (performance.now() >= deadline) {
+        break;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Run the whole program as generated JavaScript or WebAssembly, when it
+   * starts from the beginning and nothing needs to observe individual steps
+   * (a trace). Returns true if the run finished there; a runtime error is
+   * thrown like the VM would. Returns false, with the world restored, when the
+   * VM must run the program instead: unsupported program or world, budget
+   * exceeded, a repeating state or stopped.
+   *
+   * With history enabled the start is checkpointed first, so seeking back
+   * after a compiled run re-executes from there on the VM, filling in the
+   * missing checkpoints on the way.
+   */
+  private runGenerated(tier: ExecutionTier, stop: () => boolean): boolean {
+    const generated = this.prepareGenerated(tier);
+    if (!generated) {
+      return false;
+    }
+    const before = this.world.captureState();
+    const wasModified = this.world.isModified;
+    const result = generated.run(this.world, this.limits, stop);
+    return this.finishGenerated(tier, result, before, wasModified);
+  }
+
+  /**
+   * The compiled program for a tier, or null if this run cannot use it.
+   */
+  private prepareGenerated(tier: ExecutionTier): GeneratedProgram | null {
+    if (
+      tier === "vm" ||
+      !this.ast ||
+      this.trace ||
+      this.stepCount > 0 ||
+      this.pc !== this.program!.entry
+    ) {
+      return null;
+    }
+    let generated = this.generated.get(tier);
+    if (generated === undefined) {
+      generated = tier === "wasm" ? generateWasmProgram(this.ast) : generateProgram(this.ast);
+      this.generated.set(tier, generated);
+    }
+    if (!generated || generated.maxDepth > this.maxRecursionDepth) {
+      return null;
+    }
+
+    if (this.history && this.history.nextCheckpointStep === 0) {
+      this.history.add(this.captureCheckpoint());
+    }
+    return generated;
+  }
+
+  /**
+   * Take over the outcome of a compiled run (see runGenerated()).
+   */
+  private finishGenerated(
+    tier: ExecutionTier,
+    result: GeneratedRunResult,
+    before: WorldSnapshot,
+    wasModified: boolean
+  ): boolean {
+    if (result.status === "bailout") {
+      this.world.loadState(before, wasModified);
+      this.stepCount = 0;
+      this.controlCount = 0;
+      this.currentLine = 0;
+      return false;
+    }
+
+    this.stepCount = result.steps;
+    this.controlCount = result.iterations - result.steps;
+    this.currentLine = result.line;
+    this.stepCompleted = true;
+    this.executedTier = tier;
+    if (result.turnedOff) {
+      this.running = false;
+    }
+    if (result.status === "error") {
+      throw new RuntimeError(result.message!, result.line);
+    }
+    return true;
+  }
+
   /**
    * Execute a single step.
    * Returns true if there are more steps to execute, false if done.
    */
   step(): boolean {
-    if (!this.ast) {
+    if (!this.program) {
       throw new RuntimeError(ErrorMessages.programNotLoaded());
     }
 
     // Initialize step execution if not already
     if (!this.stepInitialized) {
-      this.executionStack = [
-        {
-          type: "block",
-          statements: this.ast.execution.statements,
-          index: 0,
-        },
-      ];
-      this.stepInitialized = true;
-      this.stepCompleted = false;
-      this.running = true;
-      this.iterationCount = 0;
+      this.initializeStepMode();
     }
+    this.catchUpSuspended();
 
     // If completed, nothing more to do
     if (this.stepCompleted) {
@@ -150,6 +505,7 @@ export class Interpreter {
         this.onComplete?.();
         return false;
       }
+      this.reportPause();
       return true;
     } catch (e) {
       this.stepCompleted = true;
@@ -166,203 +522,495 @@ export class Interpreter {
    * Initialize step mode without executing.
    */
   initializeStepMode(): void {
-    if (!this.ast) {
+    if (!this.program) {
       throw new RuntimeError(ErrorMessages.programNotLoaded());
     }
-    this.executionStack = [
-      {
-        type: "block",
-        statements: this.ast.execution.statements,
-        index: 0,
-      },
-    ];
+    this.pc = this.program.entry;
+    this.callStack.clear();
+    this.counters.length = 0;
+    this.stackHash.fill(0);
+    this.cycleDetector.reset();
+    this.history?.clear();
     this.stepInitialized = true;
     this.stepCompleted = false;
     this.running = true;
-    this.iterationCount = 0;
+    this.limits = { ...this.budget };
+    this.exhausted = null;
+    this.controlCount = 0;
+    this.stepCount = 0;
   }
 
   /**
-   * Execute one atomic step (one instruction).
+   * Execute one atomic step (one primitive or custom instruction call).
    */
   private executeOneStep(): boolean {
-    while (this.executionStack.length > 0) {
-      const frame = this.executionStack[this.executionStack.length - 1];
+    const { ops, args, imm, lines } = this.program!;
 
-      this.iterationCount++;
-      if (this.iterationCount > this.maxIterations) {
-        throw new RuntimeError(ErrorMessages.maxIterationsReached(this.maxIterations));
-      }
+    if (this.history && this.stepCount >= this.history.nextCheckpointStep && !this.replay) {
+      this.history.add(this.captureCheckpoint());
+    }
 
-      if (frame.type === "block" && frame.statements) {
-        if (frame.index >= frame.statements.length) {
-          // Done with this block
-          this.executionStack.pop();
-          continue;
+    while (true) {
+      // Checked before the instruction runs, so a paused run resumes right here
+      const pc = this.pc;
+      const op = ops[pc];
+      if (isStep(op)) {
+        if (this.stepCount >= this.limits.steps) {
+          return this.pause("steps");
         }
+      } else if (this.controlCount < this.limits.control) {
+        this.controlCount++;
+      } else {
+        return this.pause("control");
+      }
 
-        const statement = frame.statements[frame.index];
-        frame.index++;
+      switch (op) {
+        case OpCode.Move:
+        case OpCode.TurnLeft:
+        case OpCode.PickBeeper:
+        case OpCode.PutBeeper:
+          this.pc = pc + 1;
+          this.executePrimitive(op, lines[pc]);
+          return true;
 
-        // Handle the statement
-        if (statement.type === "call") {
-          // Execute the call and return (one step done)
-          this.executeCallSync(statement as InstructionCallNode);
-          if (!this.running) {
-            // turnoff was called
-            return false;
-          }
+        case OpCode.TurnOff:
+          this.pc = pc + 1;
+          this.reportStep(lines[pc]);
+          this.recordTrace(TraceOp.TurnOff, lines[pc], 1);
+          this.running = false;
+          return false;
+
+        case OpCode.Call:
+          // Entering a custom instruction counts as a step on the call line
+          this.reportStep(lines[pc]);
+          this.pushCall(pc + 1);
+          this.pc = args[pc];
+          this.checkpoint(lines[pc]);
           return true;
-        } else if (statement.type === "if") {
-          const ifNode = statement;
-          if (ifNode.type !== "if") {
-            return true;
-          }
-          const condition = this.world.evaluateCondition(ifNode.condition);
-          if (condition) {
-            this.executionStack.push({
-              type: "block",
-              statements: ifNode.thenBranch.statements,
-              index: 0,
-            });
-          } else if (ifNode.elseBranch) {
-            this.executionStack.push({
-              type: "block",
-              statements: ifNode.elseBranch.statements,
-              index: 0,
-            });
-          }
+
+        case OpCode.TailCall:
+          // Same step as a Call, but the callee returns straight to our caller
+          this.reportStep(lines[pc]);
+          this.pc = args[pc];
+          this.checkpoint(lines[pc]);
+          return true;
+
+        case OpCode.Return:
+          this.pc = this.popCall();
           continue;
-        } else if (statement.type === "while") {
-          const whileNode = statement;
-          if (whileNode.type !== "while") {
-            return true;
+
+        case OpCode.Jump:
+          this.pc = args[pc];
+          if (args[pc] < pc) {
+            this.checkpoint(lines[pc]);
           }
-          // Push while frame (we'll check condition in the while frame handler)
-          this.executionStack.push({
-            type: "while",
-            condition: whileNode.condition,
-            body: whileNode.body,
-            index: 0,
-          });
           continue;
-        } else if (statement.type === "iterate") {
-          const iterateNode = statement;
-          if (iterateNode.type !== "iterate") {
-            return true;
-          }
-          if (iterateNode.count > 0) {
-            this.executionStack.push({
-              type: "iterate",
-              count: iterateNode.count,
-              current: 0,
-              body: iterateNode.body,
-              index: 0,
-            });
-          }
+
+        case OpCode.JumpUnless:
+          this.pc = this.world.evaluatePredicate(imm[pc]) ? pc + 1 : args[pc];
           continue;
-        } else if (statement.type === "block") {
-          this.executionStack.push({
-            type: "block",
-            statements: (statement as BlockNode).statements,
-            index: 0,
-          });
+
+        case OpCode.IterBegin:
+          this.pushStack(this.counters, HashKind.Counter, imm[pc]);
+          this.pc = pc + 1;
           continue;
-        }
-      } else if (frame.type === "while") {
-        // Check while condition
-        if (!this.world.evaluateCondition(frame.condition!)) {
-          this.executionStack.pop();
+
+        case OpCode.IterNext: {
+          const remaining = this.counters[this.counters.length - 1] - 1;
+          if (remaining > 0) {
+            this.replaceTop(this.counters, HashKind.Counter, remaining);
+            this.pc = args[pc];
+            this.checkpoint(lines[pc]);
+          } else {
+            this.popStack(this.counters, HashKind.Counter);
+            this.pc = pc + 1;
+          }
           continue;
         }
-        // Push body as a new block frame, then re-check while
-        const bodyFrame: ExecutionFrame = {
-          type: "block",
-          statements: frame.body!.statements,
-          index: 0,
-        };
-        // Replace while frame with a fresh one for next iteration
-        this.executionStack.pop();
-        this.executionStack.push({
-          type: "while",
-          condition: frame.condition,
-          body: frame.body,
-          index: 0,
-        });
-        this.executionStack.push(bodyFrame);
-        continue;
-      } else if (frame.type === "iterate") {
-        if (frame.current! >= frame.count!) {
-          this.executionStack.pop();
+
+        case OpCode.MoveToWall:
+        case OpCode.PickAll:
+        case OpCode.PutAll: {
+          if (!this.idiomContinues(op)) {
+            this.pc = args[pc];
+            continue;
+          }
+          // Collapse the loop when nobody watches individual steps (seeking
+          // must stop on exact step counts, and a cycle replay must visit the
+          // loop's lines, so they run it one by one). Per iteration: a body
+          // step, and the back jump and next head as control.
+          if (this.silent && !this.seeking && !this.replay) {
+            const steps = this.limits.steps - this.stepCount;
+            const control = this.limits.control - this.controlCount;
+            const most = Math.min(steps, Math.floor((control + 1) / 2));
+            const count = this.idiomIterations(op, most + 1);
+            if (count <= steps && count * 2 <= control) {
+              this.controlCount += count * 2;
+              this.executeIdiom(op, count, lines[pc + 1]);
+              this.pc = args[pc];
+              return true;
+            }
+            const fit = Math.min(count, most);
+            if (fit > 0) {
+              // Only part fits the budget: stop back at this head, its next
+              // visit not counted yet, so the run pauses where the VM would
+              this.controlCount += fit * 2 - 1;
+              this.executeIdiom(op, fit, lines[pc + 1]);
+              return true;
+            }
+          }
+          this.pc = pc + 1;
           continue;
         }
-        // Push body, increment counter
-        frame.current!++;
-        this.executionStack.push({
-          type: "block",
-          statements: frame.body!.statements,
-          index: 0,
-        });
-        continue;
+
+        case OpCode.Halt:
+          return false;
+      }
+    }
+  }
+
+  /**
+   * Stop before the next instruction because a budget ran out. The VM state
+   * is kept, so extendBudget() and run() or step() carry on from here.
+   * Returns true: the program has more to execute.
+   */
+  private pause(kind: BudgetKind): boolean {
+    this.exhausted = kind;
+    this.running = false;
+    return true;
+  }
+
+  /**
+   * Tell listeners the run paused on its budget, if it did.
+   */
+  private reportPause(): void {
+    const message = this.getPauseMessage();
+    if (message !== null) {
+      this.onBudgetExhausted?.(message);
+    }
+  }
+
+  private pushCall(returnAddress: number): void {
+    const depth = this.callStack.length;
+    if (depth >= this.maxRecursionDepth) {
+      const line = this.program!.lines[returnAddress - 1];
+      const chain = formatCallChain(this.program!, this.callStack.toArray());
+      throw new RuntimeError(
+        ErrorMessages.recursionLimitReached(this.maxRecursionDepth, chain),
+        line
+      );
+    }
+    this.toggleStackKey(HashKind.CallStack, depth, returnAddress);
+    this.callStack.push(returnAddress);
+  }
+
+  private popCall(): number {
+    const returnAddress = this.callStack.pop();
+    this.toggleStackKey(HashKind.CallStack, this.callStack.length, returnAddress);
+    return returnAddress;
+  }
+
+  private pushStack(stack: number[], kind: HashKind, value: number): void {
+    this.toggleStackKey(kind, stack.length, value);
+    stack.push(value);
+  }
+
+  private popStack(stack: number[], kind: HashKind): number {
+    const value = stack.pop()!;
+    this.toggleStackKey(kind, stack.length, value);
+    return value;
+  }
+
+  /**
+   * Overwrite the top of a stack in place (a loop counter ticking down).
+   */
+  private replaceTop(stack: number[], kind: HashKind, value: number): void {
+    const depth = stack.length - 1;
+    this.toggleStackKey(kind, depth, stack[depth]);
+    this.toggleStackKey(kind, depth, value);
+    stack[depth] = value;
+  }
+
+  private toggleStackKey(kind: HashKind, depth: number, value: number): void {
+    // Loop counters can exceed 32 bits: hash their high part separately
+    const high = value / 0x100000000;
+    this.stackHash[HashLane.Lo] ^= hashKey(HashLane.Lo, kind, depth, value, high);
+    this.stackHash[HashLane.Hi] ^= hashKey(HashLane.Hi, kind, depth, value, high);
+  }
+
+  /**
+   * Called after back edges and calls, the only places where a run can start
+   * repeating itself. Hashes the full state (world, program counter and stacks);
+   * seeing the same state twice means the program can never finish.
+   */
+  private checkpoint(line: number): void {
+    const replay = this.replay;
+    if (replay) {
+      replay.lines.add(line);
+      replay.closed = this.stateKey() === replay.state;
+      return;
+    }
+    if (this.seeking) {
+      return;
+    }
+
+    const state = this.stateKey();
+    if (this.cycleDetector.check(state) > 0) {
+      throw this.infiniteLoopError(state);
+    }
+  }
+
+  /**
+   * Hash of the full state: world, program counter and stacks.
+   */
+  private stateKey(): number {
+    const pc = this.pc;
+    const lo =
+      this.world.stateHash(HashLane.Lo) ^
+      this.stackHash[HashLane.Lo] ^
+      hashKey(HashLane.Lo, HashKind.ProgramCounter, pc, 0, 0);
+    const hi =
+      this.world.stateHash(HashLane.Hi) ^
+      this.stackHash[HashLane.Hi] ^
+      hashKey(HashLane.Hi, HashKind.ProgramCounter, pc, 0, 0);
+    return combineLanes(lo, hi);
+  }
+
+  /**
+   * Run the detected cycle once more, silently, to collect the lines it goes
+   * through. The replay runs loop idioms one iteration at a time, so it visits
+   * more checkpoints than a run that collapsed them; it ends when the repeated
+   * state comes back instead of after a number of checkpoints.
+   */
+  private infiniteLoopError(state: number): RuntimeError {
+    const replay = { state, closed: false, lines: new Set<number>() };
+    const { silent, controlCount, stepCount } = this;
+
+    // The cycle already ran within the budget, so it fits again from zero
+    this.replay = replay;
+    this.silent = true;
+    this.controlCount = 0;
+    this.stepCount = 0;
+    try {
+      while (!replay.closed && this.executeOneStep() && !this.exhausted) {
+        // keep going until the cycle closes
       }
+    } finally {
+      this.replay = null;
+      this.silent = silent;
+      this.controlCount = controlCount;
+      this.stepCount = stepCount;
+    }
+
+    const lines = [...replay.lines].filter((line) => line > 0).sort((a, b) => a - b);
+    return new RuntimeError(ErrorMessages.infiniteLoop(formatLineRanges(lines)), lines[0]);
+  }
+
+  /**
+   * Whether a loop idiom's WHILE condition holds.
+   */
+  private idiomContinues(op: OpCode): boolean {
+    switch (op) {
+      case OpCode.MoveToWall:
+        return this.world.frontIsClear();
+      case OpCode.PickAll:
+        return this.world.nextToABeeper();
+      case OpCode.PutAll:
+        return this.world.beeperInBag();
+      default:
+        return false;
+    }
+  }
+
+  /**
+   * Number of iterations a loop idiom would run from the current state, or
+   * any number above `limit` if more. MoveToWall walks the cells on sparse
+   * worlds, so this is only worth asking when the loop can be collapsed.
+   */
+  private idiomIterations(op: OpCode, limit: number): number {
+    switch (op) {
+      case OpCode.MoveToWall:
+        return this.world.distanceToWall(limit);
+      case OpCode.PickAll:
+        return this.world.beepersAtKarel();
+      case OpCode.PutAll:
+        return this.world.karel.beepersInBag;
+      default:
+        return 0;
+    }
+  }
+
+  /**
+   * Run `count` iterations of a loop idiom at once.
+   * Counts as `count` steps on the body's line, like the loop it replaces.
+   */
+  private executeIdiom(op: OpCode, count: number, line: number): void {
+    this.reportStep(line);
+    this.stepCount += count - 1;
+
+    switch (op) {
+      case OpCode.MoveToWall:
+        this.world.moveForward(count);
+        this.recordTrace(TraceOp.Move, line, count);
+        break;
+      case OpCode.PickAll:
+        this.world.pickBeepers(count);
+        this.recordTrace(TraceOp.PickBeeper, line, count);
+        break;
+      case OpCode.PutAll:
+        this.world.putBeepers(count);
+        this.recordTrace(TraceOp.PutBeeper, line, count);
+        break;
+    }
+  }
+
+  /**
+   * Append executed primitives to the trace. Cycle replays and seeks re-run
+   * steps that were already recorded, so they are skipped.
+   */
+  private recordTrace(op: TraceOp, line: number, count: number): void {
+    if (this.trace && !this.replay && !this.seeking) {
+      this.trace.record(op, line, count, this.world.karel);
     }
+  }
 
-    // Stack empty - execution complete
-    return false;
+  /**
+   * Record the current line and notify listeners (not inside turbo slices).
+   */
+  private reportStep(line: number): void {
+    this.currentLine = line;
+    this.stepCount++;
+    this.replay?.lines.add(line);
+    if (!this.silent) {
+      this.onStep?.(line);
+    }
   }
 
   /**
-   * Execute a call synchronously (for step mode).
+   * Execute a world primitive, reporting the step before it runs.
    */
-  private executeCallSync(node: InstructionCallNode): void {
-    const name = node.name.toLowerCase();
-    this.currentLine = node.line;
-    this.onStep?.(node.line);
+  private executePrimitive(op: OpCode, line: number): void {
+    this.reportStep(line);
 
     try {
-      switch (name) {
-        case "move":
+      switch (op) {
+        case OpCode.Move:
           this.world.move();
+          this.recordTrace(TraceOp.Move, line, 1);
           break;
-        case "turnleft":
+        case OpCode.TurnLeft:
           this.world.turnLeft();
+          this.recordTrace(TraceOp.TurnLeft, line, 1);
           break;
-        case "pickbeeper":
+        case OpCode.PickBeeper:
           this.world.pickBeeper();
+          this.recordTrace(TraceOp.PickBeeper, line, 1);
           break;
-        case "putbeeper":
+        case OpCode.PutBeeper:
           this.world.putBeeper();
+          this.recordTrace(TraceOp.PutBeeper, line, 1);
           break;
-        case "turnoff":
-          this.running = false;
-          break;
-        default:
-          // Custom instruction - push its body onto the stack
-          const body = this.customInstructions.get(name);
-          if (body) {
-            // We need to execute the custom instruction's body
-            // But we already incremented index, so we push the body
-            // However, for custom instructions we want to step through them
-            this.executionStack.push({
-              type: "block",
-              statements: body.statements,
-              index: 0,
-            });
-            // Don't count this as a "step" - continue to first actual instruction
-            return;
-          } else {
-            throw new RuntimeError(
-              ErrorMessages.unknownInstruction(node.name, node.line),
-              node.line
-            );
-          }
       }
     } catch (e) {
       if (e instanceof Error && !(e instanceof RuntimeError)) {
-        throw new RuntimeError(e.message, node.line);
+        throw new RuntimeError(e.message, line);
+      }
+      throw e;
+    }
+  }
+
+  /**
+   * Move to the state after `target` steps, backwards or forwards. Restores the
+   * nearest checkpoint at or before the target and silently re-executes the
+   * remaining steps, so the cost is bounded by the checkpoint interval.
+   * Reports the landing step through onStep (or onComplete/onError if the
+   * program ends on the way). Returns true if more steps remain, like step().
+   */
+  seek(target: number): boolean {
+    if (!this.program) {
+      throw new RuntimeError(ErrorMessages.programNotLoaded());
+    }
+    if (!this.stepInitialized) {
+      this.initializeStepMode();
+    }
+
+    this.catchUpSuspended();
+    target = Math.max(0, Math.floor(target));
+    const checkpoint = this.history?.find(target) ?? null;
+    if (target < this.stepCount) {
+      if (!checkpoint) {
+        throw new RuntimeError(ErrorMessages.historyUnavailable());
+      }
+      this.restoreCheckpoint(checkpoint);
+    } else if (checkpoint && checkpoint.step > this.stepCount) {
+      // Skip ahead over steps already executed once
+      this.restoreCheckpoint(checkpoint);
+    } else if (this.stepCompleted) {
+      return false;
+    }
+
+    const silent = this.silent;
+    this.seeking = true;
+    this.silent = true;
+    try {
+      while (this.stepCount < target && !this.exhausted) {
+        if (!this.executeOneStep()) {
+          this.stepCompleted = true;
+          break;
+        }
+      }
+    } catch (e) {
+      this.stepCompleted = true;
+      if (e instanceof RuntimeError) {
+        this.onError?.(e);
+        return false;
       }
       throw e;
+    } finally {
+      this.seeking = false;
+      this.silent = silent;
+      // Re-executed states were not hashed; start detection over from here
+      this.cycleDetector.reset();
+    }
+
+    if (this.stepCompleted) {
+      this.onComplete?.();
+      return false;
+    }
+    if (this.currentLine > 0) {
+      this.onStep?.(this.currentLine);
     }
+    this.reportPause();
+    return true;
+  }
+
+  /**
+   * Snapshot of the VM and the world between two steps.
+   */
+  private captureCheckpoint(): Checkpoint {
+    return {
+      step: this.stepCount,
+      pc: this.pc,
+      callStack: this.callStack.toArray(),
+      counters: [...this.counters],
+      stackHash: this.stackHash.slice(),
+      controlCount: this.controlCount,
+      currentLine: this.currentLine,
+      world: this.world.captureState(),
+    };
+  }
+
+  private restoreCheckpoint(checkpoint: Checkpoint): void {
+    this.stepCount = checkpoint.step;
+    this.pc = checkpoint.pc;
+    this.callStack.load(checkpoint.callStack);
+    this.counters = [...checkpoint.counters];
+    this.stackHash.set(checkpoint.stackHash);
+    this.controlCount = checkpoint.controlCount;
+    this.currentLine = checkpoint.currentLine;
+    this.world.loadState(checkpoint.world);
+    this.stepCompleted = false;
+    this.exhausted = null;
   }
 
   /**
@@ -376,16 +1024,69 @@ export class Interpreter {
    * Reset the world to initial state.
    */
   reset(): void {
+    this.suspended = null;
     this.world.reset();
+    this.executedTier = "vm";
     this.running = false;
     this.currentLine = 0;
-    this.iterationCount = 0;
-    // Reset step execution state
-    this.executionStack = [];
+    this.exhausted = null;
+    this.controlCount = 0;
+    this.stepCount = 0;
+    // Reset VM state
+    this.pc = 0;
+    this.callStack.clear();
+    this.counters.length = 0;
+    this.stackHash.fill(0);
+    this.cycleDetector.reset();
+    this.history?.clear();
     this.stepInitialized = false;
     this.stepCompleted = false;
   }
 
+  /**
+   * Choose the engine for headless and turbo runs.
+   */
+  setTier(tier: ExecutionTier): void {
+    this.tier = tier;
+  }
+
+  /**
+   * Engine that ran the program since the last reset: "vm" unless a
+   * compiled tier finished the whole run.
+   */
+  getExecutedTier(): ExecutionTier {
+    return this.executedTier;
+  }
+
+  /**
+   * Set how deeply custom instructions may nest before the run fails.
+   * Calls in tail position do not count.
+   */
+  setMaxRecursionDepth(depth: number): void {
+    this.maxRecursionDepth = Math.max(1, Math.floor(depth));
+  }
+
+  /**
+   * Set how many steps and control instructions a run may execute before it
+   * pauses (applies from the next start of the program).
+   */
+  setBudget(budget: Partial<ExecutionBudget>): void {
+    this.budget = normalizeBudget(budget);
+  }
+
+  /**
+   * Allow another full budget on top of what has run so far, and let a
+   * paused run() continue.
+   */
+  extendBudget(): void {
+    this.limits = {
+      steps: this.stepCount + this.budget.steps,
+      control: this.controlCount + this.budget.control,
+    };
+    this.exhausted = null;
+    this.running = true;
+  }
+
   /**
    * Set execution speed in milliseconds.
    */
@@ -393,7 +1094,38 @@ export class Interpreter {
     this.executionSpeed = Math.max(50, Math.min(2000, ms));
   }
 
+  /**
+   * Enable or disable turbo mode (unthrottled, time-sliced run()).
+   */
+  setTurbo(enabled: boolean): void {
+    this.turbo = enabled;
+  }
+
   private delay(): Promise<void> {
     return new Promise((resolve) => setTimeout(resolve, this.executionSpeed));
   }
 }
+
+/**
+ * Format sorted line numbers as compact ranges, e.g. "3-5, 9".
+ */
+function formatLineRanges(lines: number[]): string {
+  const ranges: string[] = [];
+  let start = 0;
+  while (start < lines.length) {
+    let end = start;
+    while (end + 1 < lines.length && lines[end + 1] === lines[end] + 1) {
+      end++;
+    }
+    ranges.push(start === end ? `${lines[start]}` : `${lines[start]}-${lines[end]}`);
+    start = end + 1;
+  }
+  return ranges.join(", ");
+}
+
+/**
+ * Let pending I/O and UI messages run before continuing.
+ */
+function yieldToEventLoop(): Promise<void> {
+  return new Promise((resolve) => setImmediate(resolve));
+}
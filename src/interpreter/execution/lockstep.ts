@@ -0,0 +1,788 @@
+/**
+ * Lockstep engine: one compiled program over many worlds at once.
+ */
+
+import { KarelMap, Wall } from "@/interpreter/world";
+import { Direction, parseDirection } from "@/interpreter/karel";
+import { ErrorMessages } from "@/i18n/messages";
+import { OpCode, CompiledProgram, isStep } from "@/interpreter/execution/bytecode";
+import { DEFAULT_MAX_RECURSION_DEPTH, formatCallChain } from "@/interpreter/execution/callStack";
+import {
+  ExecutionBudget,
+  BudgetKind,
+  normalizeBudget,
+  budgetExhaustedMessage,
+} from "@/interpreter/execution/budget";
+import { Predicate } from "@/interpreter/parsing/constants";
+import type { HeadlessStatus } from "@/interpreter/execution/headless";
+import { DenseGrid } from "@/interpreter/storage/denseGrid";
+import { beeperCountsFitUint32 } from "@/interpreter/storage/worldGrid";
+import { WallDistances } from "@/interpreter/storage/wallDistances";
+import { Side, sideTowards } from "@/interpreter/storage/sides";
+import { HashKind, HashLane, hashKey, combineLanes } from "@/interpreter/storage/stateHash";
+
+/**
+ * Largest beeper storage (cells times worlds) the engine will allocate.
+ */
+const MAX_LOCKSTEP_CELLS = 1 << 24;
+
+/**
+ * Facing as an index: turning left adds one (mod 4).
+ */
+const DIRECTIONS = [Direction.North, Direction.West, Direction.South, Direction.East];
+const DIRECTION_INDEX: Record<Direction, number> = {
+  [Direction.North]: 0,
+  [Direction.West]: 1,
+  [Direction.South]: 2,
+  [Direction.East]: 3,
+};
+const DIRECTION_SIDES = [Side.North, Side.West, Side.South, Side.East];
+const DIRECTION_DX = [0, -1, 0, 1];
+const DIRECTION_DY = [1, 0, -1, 0];
+
+/**
+ * Outcome for one world, with the same meaning as a HeadlessResult, or
+ * "looping" when the world's state repeated: the program never finishes
+ * there, and runHeadless() gives the report (with the loop's lines).
+ */
+export interface LockstepResult {
+  status: Exclude<HeadlessStatus, "invalid"> | "looping";
+  steps: number;
+  error?: { message: string; line?: number };
+}
+
+/**
+ * Worlds that share the program counter and both stacks. They execute every
+ * instruction together until a condition sends them different ways.
+ *
+ * Control instruction and step counts are accumulated per group and only
+ * added to each member's own counters when the group changes (split, merge,
+ * end).
+ */
+interface Group {
+  pc: number;
+  callStack: number[];
+  counters: number[];
+  members: number[];
+  pendingControl: number;
+  pendingSteps: number;
+  /** Highest member control count as of the last flush. */
+  baseControl: number;
+  /** Highest member step count as of the last flush. */
+  baseSteps: number;
+  /** Zobrist hash of callStack and counters, per lane. */
+  stackHash: [number, number];
+}
+
+/**
+ * Runs one program over N worlds that share dimensions and walls.
+ *
+ * Karel poses, bags and beeper grids are stored as struct-of-arrays (one
+ * typed array per field, indexed by world), walls are stored once for all
+ * worlds, and each instruction is dispatched once per group instead of once
+ * per world. Groups whose control state becomes identical again are merged.
+ *
+ * Results match running each world with Interpreter.runHeadless(). Infinite
+ * loops are detected the same way, by hashing each world's full state after
+ * back edges and calls, but are reported as "looping" for the caller to re-run
+ * on the interpreter, which replays the cycle to name its lines.
+ */
+export class LockstepEngine {
+  private readonly program: CompiledProgram;
+  private readonly maps: KarelMap[];
+  private readonly worldCount: number;
+  private readonly width: number;
+  private readonly height: number;
+  private readonly cells: number;
+  private readonly budget: ExecutionBudget;
+  private readonly maxRecursionDepth: number;
+
+  // Shared walls
+  private readonly walls: DenseGrid;
+  private readonly wallDistances: WallDistances;
+
+  // Per-world state (struct-of-arrays)
+  private readonly x: Int32Array;
+  private readonly y: Int32Array;
+  private readonly dir: Uint8Array;
+  private readonly bag: Float64Array;
+  private readonly beepers: Uint32Array; // world-major: world * cells + cell
+  private readonly control: Float64Array;
+  private readonly steps: Float64Array;
+  private readonly results: LockstepResult[];
+
+  // Per-world infinite loop detection (Brent's, as in CycleDetector)
+  private readonly beeperHash: Uint32Array; // two lanes per world
+  private readonly cycleSaved: Float64Array;
+  private readonly cyclePower: Float64Array;
+  private readonly cycleLength: Float64Array;
+
+  /**
+   * Maps with equal keys have the same dimensions and walls (in any order).
+   */
+  static layoutKey(map: KarelMap): string {
+    return `${map.dimensions.width}x${map.dimensions.height}|${wallSetKey(map.walls)}`;
+  }
+
+  /**
+   * Check if a set of maps can run together: same dimensions and walls,
+   * everything inside the grid, and beeper counts that fit the Uint32Array
+   * cells (like DenseGrid).
+   */
+  static canRun(maps: KarelMap[]): boolean {
+    if (maps.length === 0) {
+      return false;
+    }
+    const { width, height } = maps[0].dimensions;
+    if (width * height * maps.length > MAX_LOCKSTEP_CELLS) {
+      return false;
+    }
+    const inBounds = (x: number, y: number) => x >= 1 && x <= width && y >= 1 && y <= height;
+    const layout = LockstepEngine.layoutKey(maps[0]);
+    return maps.every(
+      (map) =>
+        inBounds(map.karel.x, map.karel.y) &&
+        map.beepers.every((b) => inBounds(b.x, b.y)) &&
+        beeperCountsFitUint32(map) &&
+        LockstepEngine.layoutKey(map) === layout
+    );
+  }
+
+  /**
+   * @param program - Compiled (and optionally optimized) program
+   * @param maps - Worlds to run; must pass canRun()
+   * @param budget - Step and control limits of each world (defaults for those unset)
+   */
+  constructor(
+    program: CompiledProgram,
+    maps: KarelMap[],
+    budget: Partial<ExecutionBudget> = {},
+    maxRecursionDepth: number = DEFAULT_MAX_RECURSION_DEPTH
+  ) {
+    if (!LockstepEngine.canRun(maps)) {
+      throw new Error("Lockstep worlds must share dimensions and walls");
+    }
+
+    this.program = program;
+    this.maps = maps;
+    this.worldCount = maps.length;
+    this.width = maps[0].dimensions.width;
+    this.height = maps[0].dimensions.height;
+    this.cells = this.width * this.height;
+    this.budget = normalizeBudget(budget);
+    this.maxRecursionDepth = maxRecursionDepth;
+
+    this.walls = new DenseGrid(this.width, this.height);
+    for (const wall of maps[0].walls) {
+      const { from, to } = wall;
+      if (Math.abs(from.x - to.x) + Math.abs(from.y - to.y) !== 1) {
+        throw new Error(ErrorMessages.invalidWall(from.x, from.y, to.x, to.y));
+      }
+      this.walls.addWall(from.x, from.y, sideTowards(from.x, from.y, to.x, to.y));
+    }
+    this.wallDistances = new WallDistances(this.walls, this.width, this.height);
+
+    const n = this.worldCount;
+    this.x = new Int32Array(n);
+    this.y = new Int32Array(n);
+    this.dir = new Uint8Array(n);
+    this.bag = new Float64Array(n);
+    this.beepers = new Uint32Array(n * this.cells);
+    this.control = new Float64Array(n);
+    this.steps = new Float64Array(n);
+    this.results = new Array(n);
+    this.beeperHash = new Uint32Array(n * 2);
+    this.cycleSaved = new Float64Array(n).fill(NaN);
+    this.cyclePower = new Float64Array(n).fill(1);
+    this.cycleLength = new Float64Array(n);
+
+    maps.forEach((map, w) => {
+      this.x[w] = map.karel.x;
+      this.y[w] = map.karel.y;
+      this.dir[w] = DIRECTION_INDEX[parseDirection(map.karel.facing)];
+      this.bag[w] = map.karel.beepers ?? 0;
+      for (const b of map.beepers) {
+        this.setBeepers(w, b.x, b.y, b.count);
+      }
+    });
+  }
+
+  /**
+   * Run every world to completion. Results are in the order of the maps.
+   */
+  run(): LockstepResult[] {
+    const worklist: Group[] = [];
+    this.pushGroup(worklist, {
+      pc: this.program.entry,
+      callStack: [],
+      counters: [],
+      members: Array.from({ length: this.worldCount }, (_, w) => w),
+      pendingControl: 0,
+      pendingSteps: 0,
+      baseControl: 0,
+      baseSteps: 0,
+      stackHash: [0, 0],
+    });
+
+    while (worklist.length > 0) {
+      this.runGroup(worklist.pop()!, worklist);
+    }
+    return this.results;
+  }
+
+  /**
+   * Final state of one world, in .klm format.
+   */
+  toMap(w: number): KarelMap {
+    const beepers: KarelMap["beepers"] = [];
+    const offset = w * this.cells;
+    for (let i = 0; i < this.cells; i++) {
+      const count = this.beepers[offset + i];
+      if (count > 0) {
+        beepers.push({ x: (i % this.width) + 1, y: Math.floor(i / this.width) + 1, count });
+      }
+    }
+    return {
+      dimensions: { width: this.width, height: this.height },
+      karel: {
+        x: this.x[w],
+        y: this.y[w],
+        facing: DIRECTIONS[this.dir[w]],
+        beepers: this.bag[w],
+      },
+      beepers,
+      walls: this.maps[w].walls,
+    };
+  }
+
+  /**
+   * Execute a group until it finishes or splits (split groups go back on the worklist).
+   */
+  private runGroup(group: Group, worklist: Group[]): void {
+    const { ops, args, imm, lines } = this.program;
+
+    while (group.members.length > 0) {
+      // Members whose budget is used up pause before the instruction, like the VM
+      const pc = group.pc;
+      const op = ops[pc];
+      if (isStep(op)) {
+        if (group.baseSteps + group.pendingSteps >= this.budget.steps) {
+          this.pauseMembers(group, "steps");
+        }
+      } else if (group.baseControl + group.pendingControl >= this.budget.control) {
+        this.pauseMembers(group, "control");
+      }
+      if (group.members.length === 0) {
+        return;
+      }
+      if (!isStep(op)) {
+        group.pendingControl++;
+      }
+
+      switch (op) {
+        case OpCode.Move:
+        case OpCode.TurnLeft:
+        case OpCode.PickBeeper:
+        case OpCode.PutBeeper:
+          group.pendingSteps++;
+          group.pc = pc + 1;
+          this.executePrimitive(group, op, lines[pc]);
+          break;
+
+        case OpCode.TurnOff:
+          group.pendingSteps++;
+          this.finish(group);
+          return;
+
+        case OpCode.Halt:
+          this.finish(group);
+          return;
+
+        case OpCode.Call:
+          group.pendingSteps++;
+          if (group.callStack.length >= this.maxRecursionDepth) {
+            const message = ErrorMessages.recursionLimitReached(
+              this.maxRecursionDepth,
+              formatCallChain(this.program, group.callStack)
+            );
+            this.failMembers(group, () => true, () => ({ message, line: lines[pc] }));
+            return;
+          }
+          this.toggleStackKey(group, HashKind.CallStack, group.callStack.length, pc + 1);
+          group.callStack.push(pc + 1);
+          group.pc = args[pc];
+          this.checkpoint(group);
+          break;
+
+        case OpCode.TailCall:
+          group.pendingSteps++;
+          group.pc = args[pc];
+          this.checkpoint(group);
+          break;
+
+        case OpCode.Return: {
+          const returnAddress = group.callStack.pop()!;
+          this.toggleStackKey(group, HashKind.CallStack, group.callStack.length, returnAddress);
+          group.pc = returnAddress;
+          break;
+        }
+
+        case OpCode.Jump:
+          group.pc = args[pc];
+          if (args[pc] < pc) {
+            this.checkpoint(group);
+          }
+          break;
+
+        case OpCode.IterBegin:
+          this.toggleStackKey(group, HashKind.Counter, group.counters.length, imm[pc]);
+          group.counters.push(imm[pc]);
+          group.pc = pc + 1;
+          break;
+
+        case OpCode.IterNext: {
+          const top = group.counters.length - 1;
+          const count = group.counters[top];
+          this.toggleStackKey(group, HashKind.Counter, top, count);
+          if (count > 1) {
+            group.counters[top] = count - 1;
+            this.toggleStackKey(group, HashKind.Counter, top, count - 1);
+            group.pc = args[pc];
+            this.checkpoint(group);
+          } else {
+            group.counters.pop();
+            group.pc = pc + 1;
+          }
+          break;
+        }
+
+        case OpCode.JumpUnless:
+          if (this.branch(group, imm[pc], pc + 1, args[pc], worklist)) {
+            return;
+          }
+          break;
+
+        case OpCode.MoveToWall:
+        case OpCode.PickAll:
+        case OpCode.PutAll:
+          this.runIdiom(group, op, pc, worklist);
+          return;
+      }
+    }
+  }
+
+  /**
+   * Evaluate a condition for every member. Returns true if the group split,
+   * in which case both halves were pushed on the worklist.
+   */
+  private branch(
+    group: Group,
+    predicate: Predicate,
+    whenTrue: number,
+    whenFalse: number,
+    worklist: Group[]
+  ): boolean {
+    const taken: number[] = [];
+    const notTaken: number[] = [];
+    for (const w of group.members) {
+      (this.evaluate(predicate, w) ? taken : notTaken).push(w);
+    }
+
+    if (notTaken.length === 0 || taken.length === 0) {
+      group.pc = taken.length > 0 ? whenTrue : whenFalse;
+      return false;
+    }
+
+    this.flush(group);
+    this.pushGroup(worklist, this.fork(group, notTaken, whenFalse));
+    group.members = taken;
+    group.pc = whenTrue;
+    this.pushGroup(worklist, group);
+    return true;
+  }
+
+  /**
+   * Run a loop idiom for every member at once, each with its own iteration
+   * count. Members without enough budget run the loop body normally.
+   */
+  private runIdiom(group: Group, op: OpCode, pc: number, worklist: Group[]): void {
+    const { args } = this.program;
+    this.flush(group);
+
+    const slow: number[] = [];
+    const done: number[] = [];
+    for (const w of group.members) {
+      const count = this.idiomIterations(op, w);
+      if (count === 0) {
+        done.push(w);
+      } else if (
+        this.steps[w] + count <= this.budget.steps &&
+        this.control[w] + count * 2 <= this.budget.control
+      ) {
+        // Per iteration: a body step, and the back jump and next loop head
+        this.control[w] += count * 2;
+        this.steps[w] += count;
+        this.executeIdiom(op, w, count);
+        done.push(w);
+      } else {
+        slow.push(w);
+      }
+    }
+
+    if (slow.length > 0) {
+      // The loop condition holds for these: continue into the body
+      this.pushGroup(worklist, this.fork(group, slow, pc + 1));
+    }
+    if (done.length > 0) {
+      group.members = done;
+      group.pc = args[pc];
+      this.updateBase(group);
+      this.pushGroup(worklist, group);
+    }
+  }
+
+  private idiomIterations(op: OpCode, w: number): number {
+    switch (op) {
+      case OpCode.MoveToWall:
+        return this.wallDistances.get(this.x[w], this.y[w], DIRECTION_SIDES[this.dir[w]]);
+      case OpCode.PickAll:
+        return this.beepers[w * this.cells + this.cellIndex(this.x[w], this.y[w])];
+      case OpCode.PutAll:
+        return this.bag[w];
+      default:
+        return 0;
+    }
+  }
+
+  private executeIdiom(op: OpCode, w: number, count: number): void {
+    const cell = w * this.cells + this.cellIndex(this.x[w], this.y[w]);
+    switch (op) {
+      case OpCode.MoveToWall:
+        this.x[w] += DIRECTION_DX[this.dir[w]] * count;
+        this.y[w] += DIRECTION_DY[this.dir[w]] * count;
+        break;
+      case OpCode.PickAll:
+        this.setBeepers(w, this.x[w], this.y[w], 0);
+        this.bag[w] += count;
+        break;
+      case OpCode.PutAll:
+        this.setBeepers(w, this.x[w], this.y[w], this.beepers[cell] + count);
+        this.bag[w] = 0;
+        break;
+    }
+  }
+
+  /**
+   * Apply a primitive to every member; members it fails for leave the group.
+   */
+  private executePrimitive(group: Group, op: OpCode, line: number): void {
+    let failed: Map<number, string> | null = null;
+
+    for (const w of group.members) {
+      const message = this.applyPrimitive(op, w);
+      if (message !== null) {
+        failed = failed ?? new Map();
+        failed.set(w, message);
+      }
+    }
+
+    if (failed) {
+      const messages = failed;
+      this.failMembers(group, (w) => messages.has(w), (w) => ({
+        message: messages.get(w)!,
+        line,
+      }));
+    }
+  }
+
+  /**
+   * Apply a primitive to one world. Returns an error message, or null on success.
+   */
+  private applyPrimitive(op: OpCode, w: number): string | null {
+    const d = this.dir[w];
+    switch (op) {
+      case OpCode.Move:
+        if (this.isBlocked(this.x[w], this.y[w], DIRECTION_SIDES[d])) {
+          return ErrorMessages.moveBlocked();
+        }
+        this.x[w] += DIRECTION_DX[d];
+        this.y[w] += DIRECTION_DY[d];
+        return null;
+      case OpCode.TurnLeft:
+        this.dir[w] = (d + 1) & 3;
+        return null;
+      case OpCode.PickBeeper: {
+        const cell = w * this.cells + this.cellIndex(this.x[w], this.y[w]);
+        if (this.beepers[cell] === 0) {
+          return ErrorMessages.noBeepersToPickUp(this.x[w], this.y[w]);
+        }
+        this.setBeepers(w, this.x[w], this.y[w], this.beepers[cell] - 1);
+        this.bag[w]++;
+        return null;
+      }
+      case OpCode.PutBeeper: {
+        if (this.bag[w] <= 0) {
+          return ErrorMessages.noBeepersInBag();
+        }
+        const cell = w * this.cells + this.cellIndex(this.x[w], this.y[w]);
+        this.bag[w]--;
+        this.setBeepers(w, this.x[w], this.y[w], this.beepers[cell] + 1);
+        return null;
+      }
+      default:
+        return null;
+    }
+  }
+
+  private evaluate(predicate: Predicate, w: number): boolean {
+    const d = this.dir[w];
+    switch (predicate) {
+      case Predicate.FrontIsClear:
+        return !this.isBlocked(this.x[w], this.y[w], DIRECTION_SIDES[d]);
+      case Predicate.FrontIsBlocked:
+        return this.isBlocked(this.x[w], this.y[w], DIRECTION_SIDES[d]);
+      case Predicate.LeftIsClear:
+        return !this.isBlocked(this.x[w], this.y[w], DIRECTION_SIDES[(d + 1) & 3]);
+      case Predicate.LeftIsBlocked:
+        return this.isBlocked(this.x[w], this.y[w], DIRECTION_SIDES[(d + 1) & 3]);
+      case Predicate.RightIsClear:
+        return !this.isBlocked(this.x[w], this.y[w], DIRECTION_SIDES[(d + 3) & 3]);
+      case Predicate.RightIsBlocked:
+        return this.isBlocked(this.x[w], this.y[w], DIRECTION_SIDES[(d + 3) & 3]);
+      case Predicate.NextToABeeper:
+        return this.beepers[w * this.cells + this.cellIndex(this.x[w], this.y[w])] > 0;
+      case Predicate.NotNextToABeeper:
+        return this.beepers[w * this.cells + this.cellIndex(this.x[w], this.y[w])] === 0;
+      case Predicate.FacingNorth:
+        return d === 0;
+      case Predicate.NotFacingNorth:
+        return d !== 0;
+      case Predicate.FacingWest:
+        return d === 1;
+      case Predicate.NotFacingWest:
+        return d !== 1;
+      case Predicate.FacingSouth:
+        return d === 2;
+      case Predicate.NotFacingSouth:
+        return d !== 2;
+      case Predicate.FacingEast:
+        return d === 3;
+      case Predicate.NotFacingEast:
+        return d !== 3;
+      case Predicate.BeeperInBag:
+        return this.bag[w] > 0;
+      default:
+        throw new Error(`Unknown predicate: ${predicate}`);
+    }
+  }
+
+  private isBlocked(x: number, y: number, side: Side): boolean {
+    return this.walls.isBlocked(x, y, side);
+  }
+
+  private cellIndex(x: number, y: number): number {
+    return (y - 1) * this.width + (x - 1);
+  }
+
+  /**
+   * Store a world's beeper count, keeping its beeper hash up to date.
+   */
+  private setBeepers(w: number, x: number, y: number, count: number): void {
+    const cell = w * this.cells + this.cellIndex(x, y);
+    this.toggleBeeperKey(w, x, y, this.beepers[cell]);
+    this.toggleBeeperKey(w, x, y, count);
+    this.beepers[cell] = count;
+  }
+
+  private toggleBeeperKey(w: number, x: number, y: number, count: number): void {
+    // Empty cells contribute nothing, as in World
+    if (count > 0) {
+      this.beeperHash[w * 2] ^= hashKey(HashLane.Lo, HashKind.Beeper, x, y, count);
+      this.beeperHash[w * 2 + 1] ^= hashKey(HashLane.Hi, HashKind.Beeper, x, y, count);
+    }
+  }
+
+  private toggleStackKey(group: Group, kind: HashKind, depth: number, value: number): void {
+    // Loop counters can exceed 32 bits: hash their high part separately
+    const high = value / 0x100000000;
+    group.stackHash[HashLane.Lo] ^= hashKey(HashLane.Lo, kind, depth, value, high);
+    group.stackHash[HashLane.Hi] ^= hashKey(HashLane.Hi, kind, depth, value, high);
+  }
+
+  /**
+   * Called after back edges and calls, like the interpreter's checkpoint():
+   * members whose full state (world, program counter and stacks) repeats
+   * can never finish, and leave the group as looping.
+   */
+  private checkpoint(group: Group): void {
+    const groupLo =
+      group.stackHash[HashLane.Lo] ^ hashKey(HashLane.Lo, HashKind.ProgramCounter, group.pc, 0, 0);
+    const groupHi =
+      group.stackHash[HashLane.Hi] ^ hashKey(HashLane.Hi, HashKind.ProgramCounter, group.pc, 0, 0);
+    let looping: Set<number> | null = null;
+    for (const w of group.members) {
+      const { x, y } = this;
+      const pose = this.bag[w] * 16 + DIRECTION_SIDES[this.dir[w]];
+      const lo =
+        groupLo ^ this.beeperHash[w * 2] ^ hashKey(HashLane.Lo, HashKind.Karel, x[w], y[w], pose);
+      const hi =
+        groupHi ^
+        this.beeperHash[w * 2 + 1] ^
+        hashKey(HashLane.Hi, HashKind.Karel, x[w], y[w], pose);
+      const state = combineLanes(lo >>> 0, hi >>> 0);
+      if (state === this.cycleSaved[w]) {
+        looping = looping ?? new Set();
+        looping.add(w);
+      } else if (++this.cycleLength[w] === this.cyclePower[w]) {
+        this.cycleSaved[w] = state;
+        this.cyclePower[w] *= 2;
+        this.cycleLength[w] = 0;
+      }
+    }
+    if (looping) {
+      const members = looping;
+      this.failMembers(group, (w) => members.has(w), () => undefined, "looping");
+    }
+  }
+
+  /**
+   * Copy a group's control state for a subset of its members.
+   */
+  private fork(group: Group, members: number[], pc: number): Group {
+    const forked: Group = {
+      pc,
+      callStack: group.callStack.slice(),
+      counters: group.counters.slice(),
+      members,
+      pendingControl: 0,
+      pendingSteps: 0,
+      baseControl: 0,
+      baseSteps: 0,
+      stackHash: [group.stackHash[0], group.stackHash[1]],
+    };
+    this.updateBase(forked);
+    return forked;
+  }
+
+  /**
+   * Add a group to the worklist, merging it into a waiting group with the same
+   * control state (e.g. worlds that left the same loop after different counts).
+   */
+  private pushGroup(worklist: Group[], group: Group): void {
+    for (const other of worklist) {
+      if (
+        other.pc === group.pc &&
+        sameStack(other.callStack, group.callStack) &&
+        sameStack(other.counters, group.counters)
+      ) {
+        this.flush(other);
+        this.flush(group);
+        other.members = other.members.concat(group.members);
+        other.baseControl = Math.max(other.baseControl, group.baseControl);
+        other.baseSteps = Math.max(other.baseSteps, group.baseSteps);
+        return;
+      }
+    }
+    worklist.push(group);
+  }
+
+  /**
+   * Add a group's pending counts to each member.
+   */
+  private flush(group: Group): void {
+    if (group.pendingControl === 0 && group.pendingSteps === 0) {
+      return;
+    }
+    for (const w of group.members) {
+      this.control[w] += group.pendingControl;
+      this.steps[w] += group.pendingSteps;
+    }
+    group.baseControl += group.pendingControl;
+    group.baseSteps += group.pendingSteps;
+    group.pendingControl = 0;
+    group.pendingSteps = 0;
+  }
+
+  /**
+   * Remove the members matching `predicate` from the group with an error
+   * (or paused, with the reason as the error, or looping).
+   */
+  private failMembers(
+    group: Group,
+    predicate: (w: number) => boolean,
+    error: (w: number) => { message: string; line?: number } | undefined,
+    status: "error" | "paused" | "looping" = "error"
+  ): void {
+    this.flush(group);
+    const remaining: number[] = [];
+    for (const w of group.members) {
+      if (predicate(w)) {
+        this.results[w] = { status, steps: this.steps[w], error: error(w) };
+      } else {
+        remaining.push(w);
+      }
+    }
+    group.members = remaining;
+    this.updateBase(group);
+  }
+
+  /**
+   * Pause the members that used up one kind of budget.
+   */
+  private pauseMembers(group: Group, kind: BudgetKind): void {
+    const counts = kind === "steps" ? this.steps : this.control;
+    const limit = this.budget[kind];
+    const message = budgetExhaustedMessage(kind, limit);
+    this.failMembers(group, (w) => counts[w] >= limit, () => ({ message }), "paused");
+  }
+
+  /**
+   * Mark every member as completed.
+   */
+  private finish(group: Group): void {
+    this.flush(group);
+    for (const w of group.members) {
+      this.results[w] = { status: "completed", steps: this.steps[w] };
+    }
+    group.members = [];
+  }
+
+  /**
+   * Set a flushed group's base counts to the highest among its members.
+   */
+  private updateBase(group: Group): void {
+    group.baseControl = 0;
+    group.baseSteps = 0;
+    for (const w of group.members) {
+      group.baseControl = Math.max(group.baseControl, this.control[w]);
+      group.baseSteps = Math.max(group.baseSteps, this.steps[w]);
+    }
+  }
+}
+
+function sameStack(a: number[], b: number[]): boolean {
+  if (a.length !== b.length) {
+    return false;
+  }
+  for (let i = 0; i < a.length; i++) {
+    if (a[i] !== b[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Order-independent key of a wall list (each wall normalized to "low|high").
+ */
+function wallSetKey(walls: Wall[]): string {
+  return walls
+    .map(({ from, to }) => {
+      const a = `${from.x},${from.y}`;
+      const b = `${to.x},${to.y}`;
+      const swap = from.x > to.x || (from.x === to.x && from.y > to.y);
+      return swap ? `${b}|${a}` : `${a}|${b}`;
+    })
+    .sort()
+    .join(";");
+}
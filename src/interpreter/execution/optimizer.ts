@@ -0,0 +1,83 @@
+/**
+ * Bytecode optimizer for the Karel virtual machine.
+ */
+
+import { OpCode, CompiledProgram } from "@/interpreter/execution/bytecode";
+import { Predicate } from "@/interpreter/parsing/constants";
+
+/**
+ * WHILE loops whose body is a single primitive guarded by the condition that
+ * makes it safe. Each one can run all its iterations in O(1).
+ */
+const LOOP_IDIOMS: { predicate: Predicate; body: OpCode; idiom: OpCode }[] = [
+  { predicate: Predicate.FrontIsClear, body: OpCode.Move, idiom: OpCode.MoveToWall },
+  { predicate: Predicate.NextToABeeper, body: OpCode.PickBeeper, idiom: OpCode.PickAll },
+  { predicate: Predicate.BeeperInBag, body: OpCode.PutBeeper, idiom: OpCode.PutAll },
+];
+
+/**
+ * Replace the head of each recognized loop idiom with its idiom opcode.
+ *
+ * A WHILE loop compiles to:
+ *
+ *     top:  JumpUnless cond -> exit
+ *           <primitive>
+ *           Jump top
+ *     exit:
+ *
+ * Only the head is rewritten; the body stays in place so the interpreter can
+ * still run the loop one iteration at a time when it needs to. The program is
+ * modified in place and returned.
+ */
+export function optimizeLoopIdioms(program: CompiledProgram): CompiledProgram {
+  const { ops, args, imm } = program;
+
+  for (let pc = 0; pc + 2 < ops.length; pc++) {
+    if (
+      ops[pc] !== OpCode.JumpUnless ||
+      args[pc] !== pc + 3 ||
+      ops[pc + 2] !== OpCode.Jump ||
+      args[pc + 2] !== pc
+    ) {
+      continue;
+    }
+
+    const match = LOOP_IDIOMS.find((i) => i.predicate === imm[pc] && i.body === ops[pc + 1]);
+    if (match) {
+      ops[pc] = match.idiom;
+    }
+  }
+
+  return program;
+}
+
+/**
+ * Turn calls in tail position into tail calls, which reuse the caller's frame
+ * instead of pushing a new one. A call is in tail position when nothing but
+ * jumps separates it from its procedure's Return, e.g. the last statement of
+ * a body or of a branch of a final IF. Self-recursive instructions then run
+ * in constant stack space.
+ *
+ * Only custom instruction bodies end in Return, so calls in the execution
+ * block are never rewritten. The program is modified in place and returned.
+ */
+export function optimizeTailCalls(program: CompiledProgram): CompiledProgram {
+  const { ops, args } = program;
+
+  for (let pc = 0; pc < ops.length; pc++) {
+    if (ops[pc] !== OpCode.Call) {
+      continue;
+    }
+
+    // Follow forward jumps only, so a loop's back edge is never mistaken for an exit
+    let next = pc + 1;
+    while (ops[next] === OpCode.Jump && args[next] > next) {
+      next = args[next];
+    }
+    if (ops[next] === OpCode.Return) {
+      ops[pc] = OpCode.TailCall;
+    }
+  }
+
+  return program;
+}
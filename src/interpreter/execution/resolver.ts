@@ -0,0 +1,62 @@
+/**
+ * Name resolution for instruction calls.
+ */
+
+import { ASTNode, ProgramNode, InstructionCallNode } from "@/interpreter/types/ast";
+import { BUILT_INS } from "@/interpreter/parsing/constants";
+
+/**
+ * Bind every instruction call in a program to a built-in or a custom
+ * instruction, so nothing is looked up by name once the program runs.
+ * Built-ins take precedence, and a later definition with the same name
+ * replaces an earlier one.
+ *
+ * @returns Calls whose name matched nothing; the program cannot run if any
+ */
+export function resolveCalls(ast: ProgramNode): InstructionCallNode[] {
+  const procedures = new Map<string, number>();
+  ast.definitions.forEach((def, index) => {
+    procedures.set(def.name.toLowerCase(), index);
+  });
+
+  const unresolved: InstructionCallNode[] = [];
+
+  const resolve = (statements: ASTNode[]): void => {
+    for (const node of statements) {
+      switch (node.type) {
+        case "call": {
+          const name = node.name.toLowerCase();
+          const builtIn = BUILT_INS[name];
+          const procedure = procedures.get(name);
+          if (builtIn !== undefined) {
+            node.target = { kind: "builtin", builtIn };
+          } else if (procedure !== undefined) {
+            node.target = { kind: "procedure", index: procedure };
+          } else {
+            unresolved.push(node);
+          }
+          break;
+        }
+        case "if":
+          resolve(node.thenBranch.statements);
+          if (node.elseBranch) {
+            resolve(node.elseBranch.statements);
+          }
+          break;
+        case "while":
+        case "iterate":
+          resolve(node.body.statements);
+          break;
+        case "block":
+          resolve(node.statements);
+          break;
+      }
+    }
+  };
+
+  resolve(ast.execution.statements);
+  for (const def of ast.definitions) {
+    resolve(def.body.statements);
+  }
+  return unresolved;
+}
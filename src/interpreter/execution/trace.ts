@@ -0,0 +1,545 @@
+/**
+ * Execution traces (.kltrace).
+ *
+ * A trace stores the starting world and one record per primitive, so a run can
+ * be replayed without executing the program again. Layout:
+ *
+ *   header  "KLTR", version byte, varint length + UTF-8 JSON of the start map
+ *   record  tag byte (TraceOp | facing << 3), zigzag varint line delta,
+ *           varint run length, zigzag varint dx and dy of Karel's position
+ *   end     tag byte (TraceOp.End), zigzag varint line delta, status byte,
+ *           varint length + UTF-8 error message
+ *
+ * Pose fields hold Karel's pose after the record, relative to the previous
+ * record. Consecutive identical primitives on the same line are stored as one
+ * record with a run length, so loops like `WHILE front-is-clear DO move` take a
+ * few bytes in total. The beeper change of pickbeeper/putbeeper records is
+ * implied: the run length, taken from or added to the cell Karel stands on.
+ */
+
+import { World, KarelMap, BeeperStack } from "@/interpreter/world";
+import { Karel, Direction } from "@/interpreter/karel";
+import { ErrorMessages } from "@/i18n/messages";
+
+/**
+ * Trace record kinds. Stored in files, so values must not change.
+ */
+export enum TraceOp {
+  Move = 0,
+  TurnLeft = 1,
+  PickBeeper = 2,
+  PutBeeper = 3,
+  TurnOff = 4,
+  End = 7,
+}
+
+/**
+ * How the traced run ended. Stored in files, so values must not change.
+ */
+export enum TraceStatus {
+  Completed = 0,
+  Error = 1,
+  Stopped = 2,
+}
+
+/**
+ * One replayed primitive.
+ */
+export interface TraceStep {
+  op: TraceOp;
+  line: number;
+}
+
+/**
+ * How a replayed trace ended.
+ */
+export interface TraceEnd {
+  status: TraceStatus;
+  line: number;
+  message?: string;
+}
+
+const MAGIC = [0x4b, 0x4c, 0x54, 0x52]; // "KLTR"
+const VERSION = 1;
+const INITIAL_CAPACITY = 4096;
+
+/**
+ * Facings in tag byte order.
+ */
+const FACINGS = [Direction.North, Direction.West, Direction.South, Direction.East];
+
+/**
+ * Zigzag encoding done with arithmetic rather than 32-bit shifts, so deltas
+ * on huge sparse worlds keep every bit up to 2^52.
+ */
+function zigzag(n: number): number {
+  return n < 0 ? -2 * n - 1 : 2 * n;
+}
+
+function unzigzag(n: number): number {
+  return n % 2 === 1 ? -(n + 1) / 2 : n / 2;
+}
+
+/**
+ * Records the primitives of one run into a growable byte buffer.
+ */
+export class TraceRecorder {
+  private bytes: Uint8Array = new Uint8Array(INITIAL_CAPACITY);
+  private length: number = 0;
+  private steps: number = 0;
+  private finished: boolean = false;
+
+  // Record held back until it can no longer be extended
+  private pendingOp: TraceOp = TraceOp.End;
+  private pendingLine: number = 0;
+  private pendingCount: number = 0;
+  private pendingX: number = 0;
+  private pendingY: number = 0;
+  private pendingFacing: number = 0;
+
+  // Values the next written record is relative to
+  private lastLine: number = 0;
+  private lastX: number;
+  private lastY: number;
+
+  /**
+   * @param start - World the traced run starts from
+   */
+  constructor(start: KarelMap) {
+    const json = Buffer.from(JSON.stringify(start), "utf8");
+    MAGIC.forEach((b) => this.writeByte(b));
+    this.writeByte(VERSION);
+    this.writeVarint(json.length);
+    this.writeBytes(json);
+    this.lastX = start.karel.x;
+    this.lastY = start.karel.y;
+  }
+
+  /**
+   * Number of primitives recorded so far.
+   */
+  get stepCount(): number {
+    return this.steps + this.pendingCount;
+  }
+
+  /**
+   * Record `count` executions of a primitive that left Karel in the given pose.
+   */
+  record(op: TraceOp, line: number, count: number, karel: Karel): void {
+    if (this.finished) {
+      return;
+    }
+    if (
+      op === this.pendingOp &&
+      line === this.pendingLine &&
+      op !== TraceOp.TurnOff &&
+      this.pendingCount > 0
+    ) {
+      this.pendingCount += count;
+    } else {
+      this.flush();
+      this.pendingOp = op;
+      this.pendingLine = line;
+      this.pendingCount = count;
+    }
+    this.pendingX = karel.x;
+    this.pendingY = karel.y;
+    this.pendingFacing = FACINGS.indexOf(karel.facing);
+  }
+
+  /**
+   * Close the trace with the way the run ended. Later records are ignored.
+   */
+  finish(status: TraceStatus, line: number = 0, message: string = ""): void {
+    if (this.finished) {
+      return;
+    }
+    this.flush();
+    const text = Buffer.from(message, "utf8");
+    this.writeByte(TraceOp.End);
+    this.writeVarint(zigzag(line - this.lastLine));
+    this.writeByte(status);
+    this.writeVarint(text.length);
+    this.writeBytes(text);
+    this.finished = true;
+  }
+
+  /**
+   * Encoded trace (finish() should have been called).
+   */
+  toBytes(): Uint8Array {
+    return this.bytes.slice(0, this.length);
+  }
+
+  private flush(): void {
+    if (this.pendingCount === 0) {
+      return;
+    }
+    this.writeByte(this.pendingOp | (this.pendingFacing << 3));
+    this.writeVarint(zigzag(this.pendingLine - this.lastLine));
+    this.writeVarint(this.pendingCount);
+    this.writeVarint(zigzag(this.pendingX - this.lastX));
+    this.writeVarint(zigzag(this.pendingY - this.lastY));
+    this.lastLine = this.pendingLine;
+    this.lastX = this.pendingX;
+    this.lastY = this.pendingY;
+    this.steps += this.pendingCount;
+    this.pendingCount = 0;
+  }
+
+  private reserve(extra: number): void {
+    if (this.length + extra <= this.bytes.length) {
+      return;
+    }
+    let capacity = this.bytes.length * 2;
+    while (capacity < this.length + extra) {
+      capacity *= 2;
+    }
+    const grown = new Uint8Array(capacity);
+    grown.set(this.bytes.subarray(0, this.length));
+    this.bytes = grown;
+  }
+
+  private writeByte(value: number): void {
+    this.reserve(1);
+    this.bytes[this.length++] = value;
+  }
+
+  private writeBytes(value: Uint8Array): void {
+    this.reserve(value.length);
+    this.bytes.set(value, this.length);
+    this.length += value.length;
+  }
+
+  /**
+   * Write a non-negative safe integer. Run lengths can go past 2^32 (merged
+   * runs and collapsed idioms), so this divides instead of shifting.
+   */
+  private writeVarint(value: number): void {
+    this.reserve(8);
+    while (value >= 0x80) {
+      this.bytes[this.length++] = (value % 0x80) | 0x80;
+      value = Math.floor(value / 0x80);
+    }
+    this.bytes[this.length++] = value;
+  }
+}
+
+/**
+ * Decoder position at a record boundary and the world at that point. Only
+ * Karel is stored in full: beepers are kept as the cells changed since the
+ * previous keyframe, with their counts there, so keyframes cost as much as
+ * the changes and going back means undoing them.
+ */
+interface Keyframe {
+  step: number;
+  offset: number;
+  line: number;
+  x: number;
+  y: number;
+  karel: KarelMap["karel"];
+  undo: BeeperStack[];
+}
+
+/**
+ * Replayed steps between keyframes of a new player.
+ */
+const KEYFRAME_INTERVAL = 1000;
+
+/**
+ * Keyframes kept before every other one is dropped and the interval doubles
+ * (as in ExecutionHistory), so long traces keep a bounded number.
+ */
+const MAX_KEYFRAMES = 256;
+
+/**
+ * Replays a trace onto a world, one primitive at a time or by seeking.
+ * The trace is scanned once up front, so its length and outcome are known
+ * before anything is replayed.
+ */
+export class TracePlayer {
+  /** World the trace starts from. */
+  readonly map: KarelMap;
+  /** Number of primitives in the trace. */
+  readonly totalSteps: number;
+  /** How the run ended (null if the trace was cut short). */
+  readonly end: TraceEnd | null;
+
+  private bytes: Uint8Array;
+  private offset: number = 0;
+  private keyframes: Keyframe[];
+  private interval: number = KEYFRAME_INTERVAL;
+  private touched: Map<string, BeeperStack> = new Map(); // undo since the last keyframe
+  private _position: number = 0;
+
+  // Record being replayed
+  private op: TraceOp = TraceOp.End;
+  private line: number = 0;
+  private remaining: number = 0;
+  private x: number;
+  private y: number;
+  private facing: Direction = Direction.North;
+
+  constructor(bytes: Uint8Array) {
+    this.bytes = bytes;
+    if (MAGIC.some((b, i) => bytes[i] !== b) || bytes[MAGIC.length] !== VERSION) {
+      throw new Error(ErrorMessages.invalidTrace());
+    }
+    this.offset = MAGIC.length + 1;
+    const jsonLength = this.readVarint();
+    this.map = JSON.parse(this.readString(jsonLength)) as KarelMap;
+    this.x = this.map.karel.x;
+    this.y = this.map.karel.y;
+
+    const start: Keyframe = {
+      step: 0,
+      offset: this.offset,
+      line: 0,
+      x: this.x,
+      y: this.y,
+      karel: this.map.karel,
+      undo: [],
+    };
+    this.keyframes = [start];
+
+    // Scan every record once to validate the trace and learn its length
+    let total = 0;
+    while (this.nextRecord()) {
+      total += this.remaining;
+    }
+    this.totalSteps = total;
+    this.end = this.readEnd();
+
+    this.offset = start.offset;
+    this.line = 0;
+    this.x = start.x;
+    this.y = start.y;
+    this.remaining = 0;
+  }
+
+  /**
+   * Number of primitives applied so far.
+   */
+  get position(): number {
+    return this._position;
+  }
+
+  /**
+   * Apply the next primitive to the world.
+   * Returns null when the trace is over.
+   */
+  step(world: World): TraceStep | null {
+    return this.advance(world, 1) ? { op: this.op, line: this.line } : null;
+  }
+
+  /**
+   * Bring the world to the state after `target` primitives, forwards or
+   * backwards. Going back undoes the changes since the nearest keyframe, so
+   * a seek replays at most one keyframe interval; runs (including beeper
+   * piles) are applied in one go.
+   * Returns the line of the last applied primitive (0 at the start).
+   */
+  seek(world: World, target: number): number {
+    target = Math.max(0, Math.min(this.totalSteps, Math.floor(target)));
+
+    if (target < this._position) {
+      let index = this.keyframes.length - 1;
+      while (this.keyframes[index].step > target) {
+        index--;
+      }
+      const keyframe = this.keyframes[index];
+      this.rewind(world, index);
+      this._position = keyframe.step;
+      this.offset = keyframe.offset;
+      this.line = keyframe.line;
+      this.x = keyframe.x;
+      this.y = keyframe.y;
+      this.remaining = 0;
+    }
+
+    while (this._position < target && this.advance(world, target - this._position)) {
+      // each call applies up to the rest of one record
+    }
+    return this._position > 0 ? this.line : 0;
+  }
+
+  /**
+   * Apply up to `count` primitives from the current record, reading the next
+   * record first if the current one is used up. Returns false at the end.
+   */
+  private advance(world: World, count: number): boolean {
+    if (this.remaining === 0) {
+      const last = this.keyframes[this.keyframes.length - 1];
+      if (this._position >= last.step + this.interval) {
+        this.addKeyframe(world);
+      }
+      if (!this.nextRecord()) {
+        return false;
+      }
+    }
+
+    const n = Math.min(count, this.remaining);
+    switch (this.op) {
+      case TraceOp.Move:
+        world.moveForward(n);
+        break;
+      case TraceOp.TurnLeft:
+        world.turnLeft(n % 4);
+        break;
+      case TraceOp.PickBeeper:
+        this.touch(world);
+        world.pickBeepers(n);
+        break;
+      case TraceOp.PutBeeper:
+        this.touch(world);
+        world.putBeepers(n);
+        break;
+    }
+
+    this.remaining -= n;
+    this._position += n;
+    if (this.remaining === 0) {
+      // The record's pose must match what replaying it produced
+      const karel = world.karel;
+      if (karel.x !== this.x || karel.y !== this.y || karel.facing !== this.facing) {
+        throw new Error(ErrorMessages.invalidTrace());
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Remember the count of the cell Karel stands on before it first changes
+   * after the latest keyframe.
+   */
+  private touch(world: World): void {
+    const { x, y } = world.karel;
+    const key = `${x},${y}`;
+    if (!this.touched.has(key)) {
+      this.touched.set(key, { x, y, count: world.getBeepers({ x, y }) });
+    }
+  }
+
+  private addKeyframe(world: World): void {
+    this.keyframes.push({
+      step: this._position,
+      offset: this.offset,
+      line: this.line,
+      x: this.x,
+      y: this.y,
+      karel: world.karel.toJSON(),
+      undo: [...this.touched.values()],
+    });
+    this.touched = new Map();
+
+    if (this.keyframes.length > MAX_KEYFRAMES) {
+      // Drop every other keyframe; the undo of the next one then has to reach
+      // back to the one before, so the dropped cells are merged into it
+      const kept: Keyframe[] = [];
+      this.keyframes.forEach((keyframe, i) => {
+        if (i % 2 === 0) {
+          kept.push(keyframe);
+          return;
+        }
+        const cells = new Map(keyframe.undo.map((c) => [`${c.x},${c.y}`, c]));
+        const next = this.keyframes[i + 1];
+        for (const c of next ? next.undo : this.touched.values()) {
+          const key = `${c.x},${c.y}`;
+          if (!cells.has(key)) {
+            cells.set(key, c);
+          }
+        }
+        if (next) {
+          next.undo = [...cells.values()];
+        } else {
+          this.touched = cells;
+        }
+      });
+      this.keyframes = kept;
+      this.interval *= 2;
+    }
+  }
+
+  /**
+   * Bring the world back to a keyframe and forget the ones after it. The
+   * start is loaded from the map; later keyframes undo the changes made since,
+   * newest first.
+   */
+  private rewind(world: World, index: number): void {
+    const keyframe = this.keyframes[index];
+    if (index === 0) {
+      world.loadState({ karel: this.map.karel, beepers: this.map.beepers });
+    } else {
+      // Older counts come later in the list, so they win
+      const cells = [...this.touched.values()];
+      for (let i = this.keyframes.length - 1; i > index; i--) {
+        for (const c of this.keyframes[i].undo) {
+          cells.push(c);
+        }
+      }
+      world.applyDelta({ karel: keyframe.karel, beepers: cells });
+    }
+    this.keyframes.length = index + 1;
+    this.touched = new Map();
+  }
+
+  /**
+   * Read the next primitive record. Returns false at the end record or the
+   * end of the data, without consuming either.
+   */
+  private nextRecord(): boolean {
+    if (this.offset >= this.bytes.length || (this.bytes[this.offset] & 0x07) === TraceOp.End) {
+      return false;
+    }
+
+    const tag = this.bytes[this.offset++];
+    const op = (tag & 0x07) as TraceOp;
+    this.line += unzigzag(this.readVarint());
+    this.op = op;
+    this.remaining = this.readVarint();
+    this.x += unzigzag(this.readVarint());
+    this.y += unzigzag(this.readVarint());
+    this.facing = FACINGS[(tag >> 3) & 0x03];
+    if (op > TraceOp.TurnOff || this.remaining === 0) {
+      throw new Error(ErrorMessages.invalidTrace());
+    }
+    return true;
+  }
+
+  /**
+   * Read the end record, if the trace has one.
+   */
+  private readEnd(): TraceEnd | null {
+    if (this.offset >= this.bytes.length) {
+      return null;
+    }
+    this.offset++;
+    const line = this.line + unzigzag(this.readVarint());
+    const status = this.bytes[this.offset++] as TraceStatus;
+    const message = this.readString(this.readVarint());
+    return { status, line, message: message || undefined };
+  }
+
+  private readVarint(): number {
+    let value = 0;
+    let shift = 0;
+    while (this.offset < this.bytes.length) {
+      const byte = this.bytes[this.offset++];
+      value += (byte & 0x7f) * 2 ** shift;
+      if (byte < 0x80) {
+        return value;
+      }
+      shift += 7;
+    }
+    throw new Error(ErrorMessages.invalidTrace());
+  }
+
+  private readString(length: number): string {
+    if (this.offset + length > this.bytes.length) {
+      throw new Error(ErrorMessages.invalidTrace());
+    }
+    const text = Buffer.from(this.bytes.buffer, this.bytes.byteOffset + this.offset, length);
+    this.offset += length;
+    return text.toString("utf8");
+  }
+}
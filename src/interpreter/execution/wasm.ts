@@ -0,0 +1,852 @@
+/**
+ * WebAssembly code generation: an experimental tier for long headless runs.
+ *
+ * A resolved program is emitted directly as a WebAssembly binary module (no
+ * external toolchain) that runs on a dense copy of the world in linear
+ * memory: Karel's state in globals, one 32-bit beeper count and one wall
+ * mask byte per cell. Nothing is allocated while it runs, and the result is
+ * copied back into the World when it finishes.
+ *
+ * Instruction and step counts follow the JavaScript tier (see codegen.ts),
+ * including the AST optimizer and bulk loop idioms, so a run either matches
+ * the VM exactly or bails out for the VM to re-run. Worlds the module cannot
+ * represent (sparse storage, Karel outside the grid, beeper totals beyond 32
+ * bits) bail out before anything runs.
+ */
+
+import { ASTNode, ProgramNode, WhileNode, DefineInstructionNode } from "@/interpreter/types/ast";
+import { BuiltIn, Predicate } from "@/interpreter/parsing/constants";
+import { World, BeeperStack } from "@/interpreter/world";
+import { Direction } from "@/interpreter/karel";
+import { Side } from "@/interpreter/storage/sides";
+import { ErrorMessages } from "@/i18n/messages";
+import { optimizeAst } from "@/interpreter/execution/astOptimizer";
+import { ExecutionBudget } from "@/interpreter/execution/budget";
+import {
+  GeneratedProgram,
+  GeneratedRunResult,
+  callDepth,
+  loopIdiom,
+} from "@/interpreter/execution/codegen";
+
+// The ES2022 lib has no WebAssembly types: declare the part used here
+declare const WebAssembly: {
+  Module: new (bytes: Uint8Array) => object;
+  Instance: new (module: object) => { exports: Record<string, unknown> };
+};
+
+interface WasmMemory {
+  readonly buffer: ArrayBuffer;
+  grow(pages: number): number;
+}
+
+// Linear memory layout (byte offsets)
+const MEM_IT = 0; // f64
+const MEM_STEPS = 8; // f64
+const MEM_X = 16; // i32
+const MEM_Y = 20;
+const MEM_DIR = 24; // index into DIRECTIONS
+const MEM_BAG = 28;
+const MEM_LINE = 32;
+const MEM_ERROR = 36; // ErrorKind
+const MEM_MAX_STEPS = 40; // f64
+const MEM_SIDES = 48; // u8 wall mask bit in front of each direction
+const MEM_DX = 52; // i8 per direction
+const MEM_DY = 56; // i8 per direction
+const MEM_WIDTH = 60; // i32
+const MEM_WALLS = 64; // i32, offset of the wall masks
+const MEM_MODIFIED = 68; // i32, nonzero once a primitive changed the world
+const MEM_MAX_CONTROL = 72; // f64
+const MEM_BEEPERS = 128; // u32 per cell, then one wall mask byte per cell
+
+const PAGE_SIZE = 65536;
+
+/**
+ * Facings in turning-left order, so turnleft is `(dir + 1) & 3` and the
+ * side to the left (right) is one (three) turns further.
+ */
+const DIRECTIONS = [Direction.North, Direction.West, Direction.South, Direction.East];
+const DIRECTION_SIDES = [Side.North, Side.West, Side.South, Side.East];
+const DIRECTION_DX = [0, -1, 0, 1];
+const DIRECTION_DY = [1, 0, -1, 0];
+
+/**
+ * Largest beeper total (on the grid plus in the bag) the module can count.
+ */
+const MAX_BEEPERS = 0x7fffffff;
+
+/**
+ * Result of the exported run function.
+ */
+enum Status {
+  Completed = 0,
+  TurnedOff = 1,
+  Error = 2,
+  Bailout = 3,
+}
+
+/**
+ * Failed primitive, when the status is Error.
+ */
+enum ErrorKind {
+  MoveBlocked = 1,
+  NoBeepersToPickUp = 2,
+  NoBeepersInBag = 3,
+}
+
+// Globals
+const G_X = 0;
+const G_Y = 1;
+const G_DIR = 2;
+const G_BAG = 3;
+const G_LINE = 4;
+const G_STATUS = 5;
+const G_ERROR = 6;
+const G_WIDTH = 7;
+const G_WALLS = 8;
+const G_MODIFIED = 9;
+const G_IT = 10;
+const G_STEPS = 11;
+const G_MAX_STEPS = 12;
+const G_MAX_CONTROL = 13;
+const I32_GLOBALS = 10;
+const F64_GLOBALS = 4;
+
+// Function types
+const T_I32 = 0; // () -> i32
+const T_I32_I32 = 1; // (i32) -> i32
+const T_VOID = 2; // () -> ()
+
+// Functions; main is followed by one function per custom instruction
+const F_CELL = 0;
+const F_BLOCKED = 1;
+const F_MOVE = 2;
+const F_PICK = 3;
+const F_PUT = 4;
+const F_MOVE_TO_WALL = 5;
+const F_PICK_ALL = 6;
+const F_PUT_ALL = 7;
+const F_RUN = 8;
+const F_MAIN = 9;
+const F_PROCEDURES = 10;
+
+// Value types
+const I32 = 0x7f;
+const F64 = 0x7c;
+
+// Opcodes
+const enum Op {
+  Block = 0x02,
+  Loop = 0x03,
+  If = 0x04,
+  Else = 0x05,
+  End = 0x0b,
+  Br = 0x0c,
+  BrIf = 0x0d,
+  Return = 0x0f,
+  Call = 0x10,
+  LocalGet = 0x20,
+  LocalSet = 0x21,
+  LocalTee = 0x22,
+  GlobalGet = 0x23,
+  GlobalSet = 0x24,
+  I32Load = 0x28,
+  F64Load = 0x2b,
+  I32Load8S = 0x2c,
+  I32Load8U = 0x2d,
+  I32Store = 0x36,
+  F64Store = 0x39,
+  I32Const = 0x41,
+  F64Const = 0x44,
+  I32Eqz = 0x45,
+  I32Eq = 0x46,
+  I32Ne = 0x47,
+  F64Gt = 0x64,
+  I32Add = 0x6a,
+  I32Sub = 0x6b,
+  I32Mul = 0x6c,
+  I32And = 0x71,
+  I32Or = 0x72,
+  I32Shl = 0x74,
+  F64Add = 0xa0,
+  F64Mul = 0xa2,
+  F64Sub = 0xa1,
+  F64ConvertI32U = 0xb8,
+}
+
+const VOID_BLOCK = 0x40;
+
+/**
+ * Byte buffer with the LEB128 and IEEE encodings the binary format uses.
+ */
+class Bytes {
+  readonly bytes: number[] = [];
+
+  op(...bytes: number[]): this {
+    this.bytes.push(...bytes);
+    return this;
+  }
+
+  u32(value: number): this {
+    do {
+      let byte = value & 0x7f;
+      value >>>= 7;
+      if (value !== 0) {
+        byte |= 0x80;
+      }
+      this.bytes.push(byte);
+    } while (value !== 0);
+    return this;
+  }
+
+  s32(value: number): this {
+    for (;;) {
+      const byte = value & 0x7f;
+      value >>= 7;
+      const done = (value === 0 && (byte & 0x40) === 0) || (value === -1 && (byte & 0x40) !== 0);
+      this.bytes.push(done ? byte : byte | 0x80);
+      if (done) {
+        return this;
+      }
+    }
+  }
+
+  f64(value: number): this {
+    const view = new DataView(new ArrayBuffer(8));
+    view.setFloat64(0, value, true);
+    for (let i = 0; i < 8; i++) {
+      this.bytes.push(view.getUint8(i));
+    }
+    return this;
+  }
+
+  /** Append a length-prefixed vector or section payload. */
+  sized(content: Bytes): this {
+    this.u32(content.bytes.length);
+    this.bytes.push(...content.bytes);
+    return this;
+  }
+
+  // Instruction helpers
+
+  i32(value: number): this {
+    return this.op(Op.I32Const).s32(value);
+  }
+
+  const64(value: number): this {
+    return this.op(Op.F64Const).f64(value);
+  }
+
+  get(global: number): this {
+    return this.op(Op.GlobalGet).u32(global);
+  }
+
+  set(global: number): this {
+    return this.op(Op.GlobalSet).u32(global);
+  }
+
+  call(func: number): this {
+    return this.op(Op.Call).u32(func);
+  }
+
+  /** memarg: alignment exponent and constant offset. */
+  mem(op: Op, align: number, offset: number): this {
+    return this.op(op).u32(align).u32(offset);
+  }
+
+  /** global += constant (f64 counters). */
+  addF64(global: number, amount: number): this {
+    return this.get(global).const64(amount).op(Op.F64Add).set(global);
+  }
+
+  /** global += constant (i32). */
+  addI32(global: number, amount: number): this {
+    return this.get(global).i32(amount).op(Op.I32Add).set(global);
+  }
+
+  /** Byte offset of Karel's cell, times 4: the beeper count's address. */
+  beeperAddress(): this {
+    return this.call(F_CELL).i32(2).op(Op.I32Shl);
+  }
+
+  /** Set the status (and error kind) and return from the current function. */
+  exit(status: Status, error?: ErrorKind): this {
+    this.i32(status).set(G_STATUS);
+    if (error !== undefined) {
+      this.i32(error).set(G_ERROR);
+    }
+    return this.op(Op.Return);
+  }
+
+  /** Return if the run has ended (after calls that may end it). */
+  propagateExit(): this {
+    return this.get(G_STATUS).op(Op.If, VOID_BLOCK, Op.Return, Op.End);
+  }
+
+  /** Push whether the step or control budget is exceeded. */
+  overBudget(): this {
+    this.get(G_STEPS).get(G_MAX_STEPS).op(Op.F64Gt);
+    this.get(G_IT).get(G_STEPS).op(Op.F64Sub).get(G_MAX_CONTROL).op(Op.F64Gt);
+    return this.op(Op.I32Or);
+  }
+
+  /** Bail out once the budget is exceeded. */
+  checkBudget(): this {
+    this.overBudget().op(Op.If, VOID_BLOCK);
+    return this.exit(Status.Bailout).op(Op.End);
+  }
+
+  /** Move Karel one cell towards his facing. */
+  step(): this {
+    this.get(G_X).get(G_DIR).mem(Op.I32Load8S, 0, MEM_DX).op(Op.I32Add).set(G_X);
+    return this.get(G_Y).get(G_DIR).mem(Op.I32Load8S, 0, MEM_DY).op(Op.I32Add).set(G_Y);
+  }
+
+  /** Turn Karel left `turns` times (0-3). */
+  turn(turns: number): this {
+    return this.get(G_DIR).i32(turns).op(Op.I32Add).i32(3).op(Op.I32And).set(G_DIR);
+  }
+
+  /** Record that the world changed, like World's own primitives do. */
+  modified(): this {
+    return this.i32(1).set(G_MODIFIED);
+  }
+}
+
+/**
+ * A function body: local declarations followed by code.
+ */
+function body(locals: [count: number, type: number][], code: Bytes): Bytes {
+  const out = new Bytes().u32(locals.length);
+  for (const [count, type] of locals) {
+    out.u32(count).op(type);
+  }
+  out.bytes.push(...code.bytes);
+  return out.op(Op.End);
+}
+
+/**
+ * The fixed world primitives and the exported entry point.
+ */
+function runtimeFunctions(): Bytes[] {
+  // cell() -> (y - 1) * width + (x - 1)
+  const cell = new Bytes()
+    .get(G_Y)
+    .i32(1)
+    .op(Op.I32Sub)
+    .get(G_WIDTH)
+    .op(Op.I32Mul)
+    .get(G_X)
+    .op(Op.I32Add)
+    .i32(1)
+    .op(Op.I32Sub);
+
+  // blocked(turns) -> wall mask of Karel's cell & side `turns` left of his facing
+  const blocked = new Bytes()
+    .get(G_WALLS)
+    .call(F_CELL)
+    .op(Op.I32Add)
+    .mem(Op.I32Load8U, 0, 0)
+    .get(G_DIR)
+    .op(Op.LocalGet)
+    .u32(0)
+    .op(Op.I32Add)
+    .i32(3)
+    .op(Op.I32And)
+    .mem(Op.I32Load8U, 0, MEM_SIDES)
+    .op(Op.I32And);
+
+  const move = new Bytes().i32(0).call(F_BLOCKED).op(Op.If, VOID_BLOCK);
+  move.exit(Status.Error, ErrorKind.MoveBlocked).op(Op.End).step().modified();
+
+  // locals: address, count
+  const pick = new Bytes()
+    .beeperAddress()
+    .op(Op.LocalTee, 0)
+    .mem(Op.I32Load, 2, MEM_BEEPERS)
+    .op(Op.LocalTee, 1, Op.I32Eqz, Op.If, VOID_BLOCK);
+  pick.exit(Status.Error, ErrorKind.NoBeepersToPickUp).op(Op.End);
+  pick.op(Op.LocalGet, 0, Op.LocalGet, 1).i32(1).op(Op.I32Sub);
+  pick.mem(Op.I32Store, 2, MEM_BEEPERS).addI32(G_BAG, 1).modified();
+
+  // locals: address
+  const put = new Bytes().get(G_BAG).op(Op.I32Eqz, Op.If, VOID_BLOCK);
+  put.exit(Status.Error, ErrorKind.NoBeepersInBag).op(Op.End).addI32(G_BAG, -1);
+  put.beeperAddress().op(Op.LocalTee, 0, Op.LocalGet, 0).mem(Op.I32Load, 2, MEM_BEEPERS);
+  put.i32(1).op(Op.I32Add).mem(Op.I32Store, 2, MEM_BEEPERS).modified();
+
+  // locals: cells moved
+  const moveToWall = new Bytes().op(Op.Block, VOID_BLOCK, Op.Loop, VOID_BLOCK);
+  moveToWall.i32(0).call(F_BLOCKED).op(Op.BrIf, 1).step();
+  moveToWall.op(Op.LocalGet, 0).i32(1).op(Op.I32Add, Op.LocalSet, 0, Op.Br, 0, Op.End, Op.End);
+  moveToWall.op(Op.LocalGet, 0);
+
+  // locals: address, count
+  const pickAll = new Bytes()
+    .beeperAddress()
+    .op(Op.LocalTee, 0)
+    .mem(Op.I32Load, 2, MEM_BEEPERS)
+    .op(Op.LocalSet, 1, Op.LocalGet, 0)
+    .i32(0)
+    .mem(Op.I32Store, 2, MEM_BEEPERS)
+    .get(G_BAG)
+    .op(Op.LocalGet, 1, Op.I32Add)
+    .set(G_BAG)
+    .op(Op.LocalGet, 1);
+
+  // locals: count, address
+  const putAll = new Bytes().get(G_BAG).op(Op.LocalSet, 0).i32(0).set(G_BAG);
+  putAll.beeperAddress().op(Op.LocalTee, 1, Op.LocalGet, 1).mem(Op.I32Load, 2, MEM_BEEPERS);
+  putAll.op(Op.LocalGet, 0, Op.I32Add).mem(Op.I32Store, 2, MEM_BEEPERS).op(Op.LocalGet, 0);
+
+  // run() -> Status: load the header, run main, store the header back
+  const run = new Bytes();
+  const i32Fields: [number, number][] = [
+    [G_X, MEM_X],
+    [G_Y, MEM_Y],
+    [G_DIR, MEM_DIR],
+    [G_BAG, MEM_BAG],
+    [G_LINE, MEM_LINE],
+    [G_ERROR, MEM_ERROR],
+    [G_WIDTH, MEM_WIDTH],
+    [G_WALLS, MEM_WALLS],
+    [G_MODIFIED, MEM_MODIFIED],
+  ];
+  const f64Fields: [number, number][] = [
+    [G_IT, MEM_IT],
+    [G_STEPS, MEM_STEPS],
+    [G_MAX_STEPS, MEM_MAX_STEPS],
+    [G_MAX_CONTROL, MEM_MAX_CONTROL],
+  ];
+  for (const [global, offset] of i32Fields) {
+    run.i32(0).mem(Op.I32Load, 2, offset).set(global);
+  }
+  for (const [global, offset] of f64Fields) {
+    run.i32(0).mem(Op.F64Load, 3, offset).set(global);
+  }
+  run.i32(Status.Completed).set(G_STATUS).call(F_MAIN);
+  run.get(G_STATUS).op(Op.I32Eqz, Op.If, VOID_BLOCK).addF64(G_IT, 1).op(Op.End); // Halt
+  run.overBudget().op(Op.If, VOID_BLOCK).i32(Status.Bailout).set(G_STATUS);
+  run.op(Op.End);
+  for (const [global, offset] of [...i32Fields, ...f64Fields]) {
+    const store = global >= G_IT ? Op.F64Store : Op.I32Store;
+    run.i32(0).get(global).mem(store, global >= G_IT ? 3 : 2, offset);
+  }
+  run.get(G_STATUS);
+
+  return [
+    body([], cell),
+    body([], blocked),
+    body([], move),
+    body([[2, I32]], pick),
+    body([[1, I32]], put),
+    body([[1, I32]], moveToWall),
+    body([[2, I32]], pickAll),
+    body([[2, I32]], putAll),
+    body([], run),
+  ];
+}
+
+/**
+ * Emits the code of main and of each custom instruction.
+ *
+ * Every function has one f64 scratch local (0) for loop idioms, then one
+ * f64 counter per level of ITERATE nesting.
+ */
+class FunctionEmitter {
+  private code: Bytes = new Bytes();
+  private depth: number = 0;
+  private maxDepth: number = 0;
+
+  execution(statements: ASTNode[]): Bytes {
+    this.statements(statements);
+    return this.finish();
+  }
+
+  procedure(def: DefineInstructionNode): Bytes {
+    this.code.checkBudget();
+    this.statements(def.body.statements);
+    this.code.addF64(G_IT, 1); // Return
+    return this.finish();
+  }
+
+  private finish(): Bytes {
+    return body([[1 + this.maxDepth, F64]], this.code);
+  }
+
+  private statements(statements: ASTNode[]): void {
+    for (const node of statements) {
+      this.statement(node);
+    }
+  }
+
+  private statement(node: ASTNode): void {
+    const code = this.code;
+    switch (node.type) {
+      case "call": {
+        const target = node.target;
+        if (!target) {
+          throw new Error(`Unresolved instruction: ${node.name}`);
+        }
+        code.addF64(G_IT, 1).addF64(G_STEPS, 1).i32(node.line).set(G_LINE);
+        if (target.kind === "procedure") {
+          code.call(F_PROCEDURES + target.index).propagateExit();
+          break;
+        }
+        switch (target.builtIn) {
+          case BuiltIn.Move:
+            code.call(F_MOVE).propagateExit();
+            break;
+          case BuiltIn.TurnLeft:
+            code.turn(1).modified();
+            break;
+          case BuiltIn.PickBeeper:
+            code.call(F_PICK).propagateExit();
+            break;
+          case BuiltIn.PutBeeper:
+            code.call(F_PUT).propagateExit();
+            break;
+          case BuiltIn.TurnOff:
+            code.exit(Status.TurnedOff);
+            break;
+        }
+        break;
+      }
+      case "if":
+        code.addF64(G_IT, 1);
+        this.predicate(node.predicate);
+        code.op(Op.If, VOID_BLOCK);
+        this.statements(node.thenBranch.statements);
+        if (node.elseBranch) {
+          code.addF64(G_IT, 1); // Jump over the else branch
+          code.op(Op.Else);
+          this.statements(node.elseBranch.statements);
+        }
+        code.op(Op.End);
+        break;
+      case "while":
+        this.whileLoop(node);
+        break;
+      case "iterate": {
+        if (node.count <= 0) {
+          break;
+        }
+        const counter = 1 + this.depth++;
+        this.maxDepth = Math.max(this.maxDepth, this.depth);
+        code.addF64(G_IT, 1); // IterBegin
+        code.const64(node.count).op(Op.LocalSet).u32(counter);
+        code.op(Op.Loop, VOID_BLOCK);
+        this.statements(node.body.statements);
+        code.addF64(G_IT, 1).checkBudget(); // IterNext
+        code.op(Op.LocalGet).u32(counter).const64(1).op(Op.F64Sub, Op.LocalTee).u32(counter);
+        code.const64(0).op(Op.F64Gt, Op.BrIf, 0, Op.End);
+        this.depth--;
+        break;
+      }
+      case "block":
+        this.statements(node.statements);
+        break;
+      case "folded":
+        code.addF64(G_IT, node.iterations);
+        if (node.steps > 0) {
+          code.addF64(G_STEPS, node.steps).i32(node.line).set(G_LINE);
+        }
+        if (node.turns > 0) {
+          code.turn(node.turns % 4).modified();
+        }
+        break;
+    }
+  }
+
+  private whileLoop(node: WhileNode): void {
+    const code = this.code;
+    const idiom = loopIdiom(node);
+    if (idiom) {
+      // Per iteration: branch, body and back jump; plus the final branch
+      const bulk: Partial<Record<BuiltIn, number>> = {
+        [BuiltIn.Move]: F_MOVE_TO_WALL,
+        [BuiltIn.PickBeeper]: F_PICK_ALL,
+        [BuiltIn.PutBeeper]: F_PUT_ALL,
+      };
+      code.get(G_IT).call(bulk[idiom.builtIn]!).op(Op.F64ConvertI32U, Op.LocalTee, 0);
+      code.const64(3).op(Op.F64Mul, Op.F64Add).const64(1).op(Op.F64Add).set(G_IT);
+      code.op(Op.LocalGet, 0).const64(0).op(Op.F64Gt, Op.If, VOID_BLOCK);
+      code.get(G_STEPS).op(Op.LocalGet, 0, Op.F64Add).set(G_STEPS);
+      code.i32(idiom.call.line).set(G_LINE).modified().op(Op.End).checkBudget();
+      return;
+    }
+
+    code.op(Op.Block, VOID_BLOCK, Op.Loop, VOID_BLOCK).addF64(G_IT, 1); // JumpUnless
+    this.predicate(node.predicate);
+    code.op(Op.I32Eqz, Op.BrIf, 1);
+    this.statements(node.body.statements);
+    code.addF64(G_IT, 1).checkBudget(); // Jump back
+    code.op(Op.Br, 0, Op.End, Op.End);
+  }
+
+  /** Push a nonzero i32 if the condition holds. */
+  private predicate(predicate: Predicate): void {
+    const code = this.code;
+    const facing = (dir: number, op: Op) => code.get(G_DIR).i32(dir).op(op);
+    const beepers = () => code.beeperAddress().mem(Op.I32Load, 2, MEM_BEEPERS);
+    switch (predicate) {
+      case Predicate.FrontIsClear:
+        code.i32(0).call(F_BLOCKED).op(Op.I32Eqz);
+        break;
+      case Predicate.FrontIsBlocked:
+        code.i32(0).call(F_BLOCKED);
+        break;
+      case Predicate.LeftIsClear:
+        code.i32(1).call(F_BLOCKED).op(Op.I32Eqz);
+        break;
+      case Predicate.LeftIsBlocked:
+        code.i32(1).call(F_BLOCKED);
+        break;
+      case Predicate.RightIsClear:
+        code.i32(3).call(F_BLOCKED).op(Op.I32Eqz);
+        break;
+      case Predicate.RightIsBlocked:
+        code.i32(3).call(F_BLOCKED);
+        break;
+      case Predicate.NextToABeeper:
+        beepers();
+        break;
+      case Predicate.NotNextToABeeper:
+        beepers().op(Op.I32Eqz);
+        break;
+      case Predicate.FacingNorth:
+        facing(0, Op.I32Eq);
+        break;
+      case Predicate.NotFacingNorth:
+        facing(0, Op.I32Ne);
+        break;
+      case Predicate.FacingWest:
+        facing(1, Op.I32Eq);
+        break;
+      case Predicate.NotFacingWest:
+        facing(1, Op.I32Ne);
+        break;
+      case Predicate.FacingSouth:
+        facing(2, Op.I32Eq);
+        break;
+      case Predicate.NotFacingSouth:
+        facing(2, Op.I32Ne);
+        break;
+      case Predicate.FacingEast:
+        facing(3, Op.I32Eq);
+        break;
+      case Predicate.NotFacingEast:
+        facing(3, Op.I32Ne);
+        break;
+      case Predicate.BeeperInBag:
+        code.get(G_BAG);
+        break;
+    }
+  }
+}
+
+/**
+ * Assemble the binary module for a program.
+ */
+function emitModule(ast: ProgramNode): Uint8Array {
+  const functions = [
+    ...runtimeFunctions(),
+    new FunctionEmitter().execution(ast.execution.statements),
+    ...ast.definitions.map((def) => new FunctionEmitter().procedure(def)),
+  ];
+  const types = [T_I32, T_I32_I32, T_VOID, T_VOID, T_VOID, T_I32, T_I32, T_I32, T_I32, T_VOID];
+  while (types.length < functions.length) {
+    types.push(T_VOID);
+  }
+
+  const typeSection = new Bytes().u32(3);
+  typeSection.op(0x60).u32(0).u32(1).op(I32); // () -> i32
+  typeSection.op(0x60).u32(1).op(I32).u32(1).op(I32); // (i32) -> i32
+  typeSection.op(0x60).u32(0).u32(0); // () -> ()
+
+  const funcSection = new Bytes().u32(types.length);
+  for (const type of types) {
+    funcSection.u32(type);
+  }
+
+  const memorySection = new Bytes().u32(1).op(0x00).u32(1); // one page, no maximum
+
+  const globalSection = new Bytes().u32(I32_GLOBALS + F64_GLOBALS);
+  for (let i = 0; i < I32_GLOBALS; i++) {
+    globalSection.op(I32, 0x01).i32(0).op(Op.End);
+  }
+  for (let i = 0; i < F64_GLOBALS; i++) {
+    globalSection.op(F64, 0x01).const64(0).op(Op.End);
+  }
+
+  const exportSection = new Bytes().u32(2);
+  const name = (text: string) =>
+    exportSection.u32(text.length).op(...[...text].map((c) => c.charCodeAt(0)));
+  name("run");
+  exportSection.op(0x00).u32(F_RUN);
+  name("memory");
+  exportSection.op(0x02).u32(0);
+
+  const codeSection = new Bytes().u32(functions.length);
+  for (const fn of functions) {
+    codeSection.sized(fn);
+  }
+
+  const module = new Bytes().op(0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00);
+  const sections: [number, Bytes][] = [
+    [1, typeSection],
+    [3, funcSection],
+    [5, memorySection],
+    [6, globalSection],
+    [7, exportSection],
+    [10, codeSection],
+  ];
+  for (const [id, section] of sections) {
+    module.op(id).sized(section);
+  }
+  return Uint8Array.from(module.bytes);
+}
+
+/**
+ * Compile a program whose calls have been bound by resolveCalls() to a
+ * WebAssembly module. Returns null for recursive programs, which need the
+ * VM's own call stack.
+ *
+ * The module cannot be interrupted: `stop` is not polled, so only use it
+ * where a run may take as long as its instruction budget allows.
+ */
+export function generateWasmProgram(ast: ProgramNode): GeneratedProgram | null {
+  const maxDepth = callDepth(ast);
+  if (maxDepth === null) {
+    return null;
+  }
+
+  const instance = new WebAssembly.Instance(new WebAssembly.Module(emitModule(optimizeAst(ast))));
+  const runModule = instance.exports.run as () => Status;
+  const memory = instance.exports.memory as WasmMemory;
+
+  return {
+    maxDepth,
+    run: (world, budget) => runOnMemory(world, budget, runModule, memory),
+  };
+}
+
+function runOnMemory(
+  world: World,
+  budget: ExecutionBudget,
+  runModule: () => Status,
+  memory: WasmMemory
+): GeneratedRunResult {
+  const bailout: GeneratedRunResult = {
+    status: "bailout",
+    turnedOff: false,
+    steps: 0,
+    iterations: 0,
+    line: 0,
+  };
+  const cells = world.denseCells();
+  const karel = world.karel;
+  const { width, height } = world;
+  if (
+    !cells ||
+    !Number.isInteger(karel.x) ||
+    !Number.isInteger(karel.y) ||
+    karel.x < 1 ||
+    karel.x > width ||
+    karel.y < 1 ||
+    karel.y > height ||
+    !Number.isInteger(karel.beepersInBag)
+  ) {
+    return bailout;
+  }
+  let total = karel.beepersInBag;
+  for (let i = 0; i < cells.beepers.length; i++) {
+    total += cells.beepers[i];
+  }
+  if (total > MAX_BEEPERS) {
+    return bailout;
+  }
+
+  const count = width * height;
+  const wallsOffset = MEM_BEEPERS + count * 4;
+  const needed = wallsOffset + count;
+  if (memory.buffer.byteLength < needed) {
+    memory.grow(Math.ceil((needed - memory.buffer.byteLength) / PAGE_SIZE));
+  }
+
+  const buffer = memory.buffer;
+  const view = new DataView(buffer);
+  view.setFloat64(MEM_IT, 0, true);
+  view.setFloat64(MEM_STEPS, 0, true);
+  view.setInt32(MEM_X, karel.x, true);
+  view.setInt32(MEM_Y, karel.y, true);
+  view.setInt32(MEM_DIR, DIRECTIONS.indexOf(karel.facing), true);
+  view.setInt32(MEM_BAG, karel.beepersInBag, true);
+  view.setInt32(MEM_LINE, 0, true);
+  view.setInt32(MEM_ERROR, 0, true);
+  view.setFloat64(MEM_MAX_STEPS, budget.steps, true);
+  view.setFloat64(MEM_MAX_CONTROL, budget.control, true);
+  view.setInt32(MEM_WIDTH, width, true);
+  view.setInt32(MEM_WALLS, wallsOffset, true);
+  view.setInt32(MEM_MODIFIED, 0, true);
+  for (let dir = 0; dir < 4; dir++) {
+    view.setUint8(MEM_SIDES + dir, DIRECTION_SIDES[dir]);
+    view.setInt8(MEM_DX + dir, DIRECTION_DX[dir]);
+    view.setInt8(MEM_DY + dir, DIRECTION_DY[dir]);
+  }
+  const beepers = new Uint32Array(buffer, MEM_BEEPERS, count);
+  beepers.set(cells.beepers);
+  new Uint8Array(buffer, wallsOffset, count).set(cells.blocked);
+
+  const status = runModule();
+  const steps = view.getFloat64(MEM_STEPS, true);
+  const iterations = view.getFloat64(MEM_IT, true);
+  const line = view.getInt32(MEM_LINE, true);
+  if (status === Status.Bailout) {
+    return { ...bailout, steps, iterations, line };
+  }
+
+  // Copy the result back
+  const x = view.getInt32(MEM_X, true);
+  const y = view.getInt32(MEM_Y, true);
+  const stack: BeeperStack[] = [];
+  for (let i = 0; i < count; i++) {
+    if (beepers[i] > 0) {
+      stack.push({ x: (i % width) + 1, y: Math.floor(i / width) + 1, count: beepers[i] });
+    }
+  }
+  world.loadState(
+    {
+      karel: {
+        x,
+        y,
+        facing: DIRECTIONS[view.getInt32(MEM_DIR, true)],
+        beepers: view.getInt32(MEM_BAG, true),
+      },
+      beepers: stack,
+    },
+    world.isModified || view.getInt32(MEM_MODIFIED, true) !== 0
+  );
+
+  const result: GeneratedRunResult = {
+    status: status === Status.Error ? "error" : "completed",
+    turnedOff: status === Status.TurnedOff,
+    steps,
+    iterations,
+    line,
+  };
+  if (status === Status.Error) {
+    switch (view.getInt32(MEM_ERROR, true) as ErrorKind) {
+      case ErrorKind.MoveBlocked:
+        result.message = ErrorMessages.moveBlocked();
+        break;
+      case ErrorKind.NoBeepersToPickUp:
+        result.message = ErrorMessages.noBeepersToPickUp(x, y);
+        break;
+      case ErrorKind.NoBeepersInBag:
+        result.message = ErrorMessages.noBeepersInBag();
+        break;
+    }
+  }
+  return result;
+}
@@ -2,9 +2,17 @@ export { Karel, Direction } from "./karel";
 export type { Position } from "./karel";
 
 export { World } from "./world";
-export type { KarelMap } from "./world";
+export type { KarelMap, WorldDelta, WorldSnapshot } from "./world";
 
 export { Interpreter } from "./execution/interpreter";
+export type { ExecutionTier } from "./execution/interpreter";
+export { runHeadless } from "./execution/headless";
+export { DEFAULT_MAX_RECURSION_DEPTH } from "./execution/callStack";
+export { DEFAULT_EXECUTION_BUDGET } from "./execution/budget";
+export type { ExecutionBudget } from "./execution/budget";
+export type { HeadlessResult, HeadlessStatus, HeadlessOptions } from "./execution/headless";
+export { TraceRecorder, TracePlayer, TraceOp, TraceStatus } from "./execution/trace";
+export type { TraceStep, TraceEnd } from "./execution/trace";
 export { Parser } from "./parsing/parser";
 export { ParseError, RuntimeError } from "./types/errors";
 export type { Diagnostic } from "./types/errors";
@@ -81,9 +81,12 @@ export function parseDirection(value: string): Direction {
 
 /**
  * Karel robot state and operations.
+ * Coordinates are kept as plain numbers so that moving and reading them
+ * never allocates; `position` builds an object only for callers that ask.
  */
 export class Karel {
-  private _position: Position;
+  private _x: number;
+  private _y: number;
   private _facing: Direction;
   private _beepersInBag: number;
 
@@ -92,7 +95,8 @@ export class Karel {
     facing: Direction = Direction.North,
     beepersInBag: number = 0
   ) {
-    this._position = { ...position };
+    this._x = position.x;
+    this._y = position.y;
     this._facing = facing;
     this._beepersInBag = beepersInBag;
   }
@@ -101,21 +105,21 @@ export class Karel {
    * Current position of Karel.
    */
   get position(): Position {
-    return { ...this._position };
+    return { x: this._x, y: this._y };
   }
 
   /**
    * Current X coordinate.
    */
   get x(): number {
-    return this._position.x;
+    return this._x;
   }
 
   /**
    * Current Y coordinate.
    */
   get y(): number {
-    return this._position.y;
+    return this._y;
   }
 
   /**
@@ -145,8 +149,8 @@ export class Karel {
   frontPosition(): Position {
     const vector = DirectionVectors[this._facing];
     return {
-      x: this._position.x + vector.x,
-      y: this._position.y + vector.y,
+      x: this._x + vector.x,
+      y: this._y + vector.y,
     };
   }
 
@@ -157,8 +161,8 @@ export class Karel {
     const leftDir = LeftTurnMap[this._facing];
     const vector = DirectionVectors[leftDir];
     return {
-      x: this._position.x + vector.x,
-      y: this._position.y + vector.y,
+      x: this._x + vector.x,
+      y: this._y + vector.y,
     };
   }
 
@@ -169,25 +173,28 @@ export class Karel {
     const rightDir = RightTurnMap[this._facing];
     const vector = DirectionVectors[rightDir];
     return {
-      x: this._position.x + vector.x,
-      y: this._position.y + vector.y,
+      x: this._x + vector.x,
+      y: this._y + vector.y,
     };
   }
 
   /**
-   * Move Karel forward one cell.
+   * Move Karel forward one cell (or `steps` cells).
    * This only updates Karel's position - wall checking should be done by World.
    */
-  move(): void {
-    const front = this.frontPosition();
-    this._position = front;
+  move(steps: number = 1): void {
+    const vector = DirectionVectors[this._facing];
+    this._x += vector.x * steps;
+    this._y += vector.y * steps;
   }
 
   /**
-   * Turn Karel 90° counter-clockwise.
+   * Turn Karel 90° counter-clockwise (or `times` times).
    */
-  turnLeft(): void {
-    this._facing = LeftTurnMap[this._facing];
+  turnLeft(times: number = 1): void {
+    for (let i = times % 4; i > 0; i--) {
+      this._facing = LeftTurnMap[this._facing];
+    }
   }
 
   /**
@@ -214,7 +221,8 @@ export class Karel {
    * Set position directly (for initialization or reset).
    */
   setPosition(position: Position): void {
-    this._position = { ...position };
+    this._x = position.x;
+    this._y = position.y;
   }
 
   /**
@@ -242,7 +250,7 @@ export class Karel {
    * Create a deep clone of Karel's current state.
    */
   clone(): Karel {
-    return new Karel(this._position, this._facing, this._beepersInBag);
+    return new Karel({ x: this._x, y: this._y }, this._facing, this._beepersInBag);
   }
 
   /**
@@ -250,8 +258,8 @@ export class Karel {
    */
   toJSON(): { x: number; y: number; facing: string; beepers: number } {
     return {
-      x: this._position.x,
-      y: this._position.y,
+      x: this._x,
+      y: this._y,
       facing: this._facing,
       beepers: this._beepersInBag,
     };
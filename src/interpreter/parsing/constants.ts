@@ -2,36 +2,81 @@
  * Constants for Karel language validation.
  */
 
+/**
+ * Conditions as numeric ids, resolved by the parser so the runtime never
+ * looks at condition names.
+ */
+export enum Predicate {
+  FrontIsClear,
+  FrontIsBlocked,
+  LeftIsClear,
+  LeftIsBlocked,
+  RightIsClear,
+  RightIsBlocked,
+  NextToABeeper,
+  NotNextToABeeper,
+  FacingNorth,
+  NotFacingNorth,
+  FacingSouth,
+  NotFacingSouth,
+  FacingEast,
+  NotFacingEast,
+  FacingWest,
+  NotFacingWest,
+  BeeperInBag,
+}
+
+/**
+ * Predicate of each condition name (lowercase).
+ */
+export const PREDICATES: Record<string, Predicate> = {
+  "front-is-clear": Predicate.FrontIsClear,
+  "front-is-blocked": Predicate.FrontIsBlocked,
+  "left-is-clear": Predicate.LeftIsClear,
+  "left-is-blocked": Predicate.LeftIsBlocked,
+  "right-is-clear": Predicate.RightIsClear,
+  "right-is-blocked": Predicate.RightIsBlocked,
+  "next-to-a-beeper": Predicate.NextToABeeper,
+  "not-next-to-a-beeper": Predicate.NotNextToABeeper,
+  "facing-north": Predicate.FacingNorth,
+  "not-facing-north": Predicate.NotFacingNorth,
+  "facing-south": Predicate.FacingSouth,
+  "not-facing-south": Predicate.NotFacingSouth,
+  "facing-east": Predicate.FacingEast,
+  "not-facing-east": Predicate.NotFacingEast,
+  "facing-west": Predicate.FacingWest,
+  "not-facing-west": Predicate.NotFacingWest,
+  "beeper-in-bag": Predicate.BeeperInBag,
+};
+
 /**
  * Valid condition names.
  */
-export const VALID_CONDITIONS = new Set([
-  "front-is-clear",
-  "front-is-blocked",
-  "left-is-clear",
-  "left-is-blocked",
-  "right-is-clear",
-  "right-is-blocked",
-  "next-to-a-beeper",
-  "not-next-to-a-beeper",
-  "facing-north",
-  "not-facing-north",
-  "facing-south",
-  "not-facing-south",
-  "facing-east",
-  "not-facing-east",
-  "facing-west",
-  "not-facing-west",
-  "beeper-in-bag",
-]);
+export const VALID_CONDITIONS = new Set(Object.keys(PREDICATES));
+
+/**
+ * Built-in instructions as numeric ids.
+ */
+export enum BuiltIn {
+  Move,
+  TurnLeft,
+  PickBeeper,
+  PutBeeper,
+  TurnOff,
+}
+
+/**
+ * Built-in of each instruction name (lowercase).
+ */
+export const BUILT_INS: Record<string, BuiltIn> = {
+  move: BuiltIn.Move,
+  turnleft: BuiltIn.TurnLeft,
+  pickbeeper: BuiltIn.PickBeeper,
+  putbeeper: BuiltIn.PutBeeper,
+  turnoff: BuiltIn.TurnOff,
+};
 
 /**
  * Built-in instruction names.
  */
-export const BUILT_IN_INSTRUCTIONS = new Set([
-  "move",
-  "turnleft",
-  "pickbeeper",
-  "putbeeper",
-  "turnoff",
-]);
+export const BUILT_IN_INSTRUCTIONS = new Set(Object.keys(BUILT_INS));
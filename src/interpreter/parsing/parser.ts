@@ -16,7 +16,7 @@ import {
 import { ParseError, Diagnostic } from "@/interpreter/types/errors";
 import { ErrorMessages } from "@/i18n/messages";
 import { Lexer } from "@/interpreter/parsing/lexer";
-import { BUILT_IN_INSTRUCTIONS } from "@/interpreter/parsing/constants";
+import { BUILT_IN_INSTRUCTIONS, PREDICATES } from "@/interpreter/parsing/constants";
 
 /**
  * Parser for Karel instructions.
@@ -217,6 +217,7 @@ export class Parser {
     return {
       type: "if",
       condition,
+      predicate: PREDICATES[condition.toLowerCase()],
       thenBranch,
       elseBranch,
       line: ifToken.line,
@@ -247,6 +248,7 @@ export class Parser {
     return {
       type: "while",
       condition,
+      predicate: PREDICATES[condition.toLowerCase()],
       body,
       line: whileToken.line,
     };
@@ -259,7 +261,15 @@ export class Parser {
     if (!this.check(TokenType.Number)) {
       throw new ParseError(ErrorMessages.invalidIterateCount(this.peek().line), this.peek().line);
     }
-    const count = parseInt(this.advance().value, 10);
+    // Any digit string lexes as a number; counts must stay exact as doubles
+    const countToken = this.advance();
+    const count = Number(countToken.value);
+    if (!Number.isSafeInteger(count)) {
+      throw new ParseError(
+        ErrorMessages.iterateCountTooLarge(countToken.line, Number.MAX_SAFE_INTEGER),
+        countToken.line
+      );
+    }
 
     // Expect TIMES
     if (!this.check(TokenType.Times)) {
@@ -0,0 +1,208 @@
+/**
+ * Dense typed-array world storage.
+ */
+
+import type { WorldGrid } from "@/interpreter/storage/worldGrid";
+import { Side, SideOffsets, oppositeSide } from "@/interpreter/storage/sides";
+import { wallKey } from "@/interpreter/storage/sparseGrid";
+
+/**
+ * Stores beepers in a Uint32Array and walls in a per-cell 4-bit mask,
+ * both indexed by (y - 1) * width + (x - 1).
+ *
+ * The mask also has the border sides set, so a sensor check is one array load.
+ * Walls with a cell outside the grid (on the border or beyond) have no mask bit;
+ * they are kept in a set like SparseGrid keeps all walls, so maps round-trip
+ * the same on both backends.
+ */
+export class DenseGrid implements WorldGrid {
+  readonly kind = "dense";
+
+  private readonly width: number;
+  private readonly height: number;
+  private readonly beepers: Uint32Array;
+  private readonly blocked: Uint8Array;
+  private readonly outerWalls: Set<string> = new Set();
+
+  // Undo log since saveInitialBeepers(): first write to each cell records its
+  // index and previous count; a bitset marks the cells already logged
+  private logged: Uint8Array | null = null;
+  private undoCells: number[] = [];
+  private undoCounts: number[] = [];
+
+  constructor(width: number, height: number) {
+    this.width = width;
+    this.height = height;
+    this.beepers = new Uint32Array(width * height);
+    this.blocked = new Uint8Array(width * height);
+
+    // Close the border
+    for (let x = 1; x <= width; x++) {
+      this.blocked[this.index(x, 1)] |= Side.South;
+      this.blocked[this.index(x, height)] |= Side.North;
+    }
+    for (let y = 1; y <= height; y++) {
+      this.blocked[this.index(1, y)] |= Side.West;
+      this.blocked[this.index(width, y)] |= Side.East;
+    }
+  }
+
+  private index(x: number, y: number): number {
+    return (y - 1) * this.width + (x - 1);
+  }
+
+  private inBounds(x: number, y: number): boolean {
+    return x >= 1 && x <= this.width && y >= 1 && y <= this.height;
+  }
+
+  getBeepers(x: number, y: number): number {
+    if (!this.inBounds(x, y)) {
+      return 0;
+    }
+    return this.beepers[this.index(x, y)];
+  }
+
+  setBeepers(x: number, y: number, count: number): void {
+    if (this.inBounds(x, y)) {
+      const i = this.index(x, y);
+      this.logWrite(i);
+      this.beepers[i] = count;
+    }
+  }
+
+  private logWrite(i: number): void {
+    const logged = this.logged;
+    if (logged && (logged[i >> 3] & (1 << (i & 7))) === 0) {
+      logged[i >> 3] |= 1 << (i & 7);
+      this.undoCells.push(i);
+      this.undoCounts.push(this.beepers[i]);
+    }
+  }
+
+  hasWall(x: number, y: number, side: Side): boolean {
+    const { dx, dy } = SideOffsets[side];
+    const nx = x + dx;
+    const ny = y + dy;
+    // Border bits belong to the border, not to a wall
+    if (!this.inBounds(x, y) || !this.inBounds(nx, ny)) {
+      return this.outerWalls.has(wallKey(x, y, nx, ny));
+    }
+    return (this.blocked[this.index(x, y)] & side) !== 0;
+  }
+
+  addWall(x: number, y: number, side: Side): void {
+    this.setWall(x, y, side, true);
+  }
+
+  removeWall(x: number, y: number, side: Side): void {
+    this.setWall(x, y, side, false);
+  }
+
+  private setWall(x: number, y: number, side: Side, present: boolean): void {
+    const { dx, dy } = SideOffsets[side];
+    const nx = x + dx;
+    const ny = y + dy;
+    if (!this.inBounds(x, y) || !this.inBounds(nx, ny)) {
+      const key = wallKey(x, y, nx, ny);
+      if (present) {
+        this.outerWalls.add(key);
+      } else {
+        this.outerWalls.delete(key);
+      }
+      return;
+    }
+    const opposite = oppositeSide(side);
+    if (present) {
+      this.blocked[this.index(x, y)] |= side;
+      this.blocked[this.index(nx, ny)] |= opposite;
+    } else {
+      this.blocked[this.index(x, y)] &= ~side;
+      this.blocked[this.index(nx, ny)] &= ~opposite;
+    }
+  }
+
+  isBlocked(x: number, y: number, side: Side): boolean {
+    if (!this.inBounds(x, y)) {
+      const { dx, dy } = SideOffsets[side];
+      const nx = x + dx;
+      const ny = y + dy;
+      return !this.inBounds(nx, ny) || this.outerWalls.has(wallKey(x, y, nx, ny));
+    }
+    return (this.blocked[this.index(x, y)] & side) !== 0;
+  }
+
+  /**
+   * The live cell arrays, for bulk readers. Must not be modified.
+   */
+  get cells(): { beepers: Uint32Array; blocked: Uint8Array } {
+    return { beepers: this.beepers, blocked: this.blocked };
+  }
+
+  forEachBeeper(callback: (x: number, y: number, count: number) => void): void {
+    const beepers = this.beepers;
+    for (let i = 0; i < beepers.length; i++) {
+      if (beepers[i] > 0) {
+        callback((i % this.width) + 1, Math.floor(i / this.width) + 1, beepers[i]);
+      }
+    }
+  }
+
+  forEachWall(callback: (x1: number, y1: number, x2: number, y2: number) => void): void {
+    // Report each interior wall once, from the cell to its west or south
+    for (let y = 1; y <= this.height; y++) {
+      for (let x = 1; x <= this.width; x++) {
+        const mask = this.blocked[this.index(x, y)];
+        if (x < this.width && (mask & Side.East) !== 0) {
+          callback(x, y, x + 1, y);
+        }
+        if (y < this.height && (mask & Side.North) !== 0) {
+          callback(x, y, x, y + 1);
+        }
+      }
+    }
+    for (const key of this.outerWalls) {
+      const [fromX, fromY, toX, toY] = key.split(/[,|]/).map(Number);
+      callback(fromX, fromY, toX, toY);
+    }
+  }
+
+  clearBeepers(): void {
+    const beepers = this.beepers;
+    if (this.logged) {
+      for (let i = 0; i < beepers.length; i++) {
+        if (beepers[i] > 0) {
+          this.logWrite(i);
+        }
+      }
+    }
+    beepers.fill(0);
+  }
+
+  saveInitialBeepers(): void {
+    this.logged = new Uint8Array((this.beepers.length + 7) >> 3);
+    this.undoCells = [];
+    this.undoCounts = [];
+  }
+
+  resetBeepers(onChange?: (x: number, y: number, from: number, to: number) => void): void {
+    const logged = this.logged;
+    if (!logged) {
+      this.clearBeepers();
+      return;
+    }
+
+    const { undoCells, undoCounts, beepers } = this;
+    for (let k = 0; k < undoCells.length; k++) {
+      const i = undoCells[k];
+      const from = beepers[i];
+      const to = undoCounts[k];
+      logged[i >> 3] = 0; // every marked cell is in the log, so whole bytes can be cleared
+      if (from !== to) {
+        beepers[i] = to;
+        onChange?.((i % this.width) + 1, Math.floor(i / this.width) + 1, from, to);
+      }
+    }
+    undoCells.length = 0;
+    undoCounts.length = 0;
+  }
+}
@@ -0,0 +1,52 @@
+/**
+ * Cell sides and wall mask bits.
+ */
+
+/**
+ * Side of a cell, as a bit in a 4-bit wall mask.
+ */
+export enum Side {
+  North = 1,
+  East = 2,
+  South = 4,
+  West = 8,
+}
+
+/**
+ * Cell offset for each side.
+ */
+export const SideOffsets: Record<Side, { dx: number; dy: number }> = {
+  [Side.North]: { dx: 0, dy: 1 },
+  [Side.East]: { dx: 1, dy: 0 },
+  [Side.South]: { dx: 0, dy: -1 },
+  [Side.West]: { dx: -1, dy: 0 },
+};
+
+/**
+ * Get the side of `from` that faces the adjacent cell `to`.
+ */
+export function sideTowards(fromX: number, fromY: number, toX: number, toY: number): Side {
+  if (toX > fromX) {
+    return Side.East;
+  }
+  if (toX < fromX) {
+    return Side.West;
+  }
+  return toY > fromY ? Side.North : Side.South;
+}
+
+/**
+ * Get the opposite side.
+ */
+export function oppositeSide(side: Side): Side {
+  switch (side) {
+    case Side.North:
+      return Side.South;
+    case Side.East:
+      return Side.West;
+    case Side.South:
+      return Side.North;
+    case Side.West:
+      return Side.East;
+  }
+}
@@ -0,0 +1,143 @@
+/**
+ * Sparse string-keyed world storage.
+ */
+
+import type { WorldGrid } from "@/interpreter/storage/worldGrid";
+import { Side, SideOffsets } from "@/interpreter/storage/sides";
+
+/**
+ * Generates a unique key for a wall between two positions.
+ * Normalizes the order so (A,B) and (B,A) produce the same key.
+ */
+export function wallKey(x1: number, y1: number, x2: number, y2: number): string {
+  // Sort positions to ensure consistent key regardless of direction
+  if (x1 < x2 || (x1 === x2 && y1 < y2)) {
+    return `${x1},${y1}|${x2},${y2}`;
+  }
+  return `${x2},${y2}|${x1},${y1}`;
+}
+
+/**
+ * Generates a unique key for a position.
+ */
+function positionKey(x: number, y: number): string {
+  return `${x},${y}`;
+}
+
+/**
+ * Stores beepers in a Map keyed by "x,y" and walls in a Set keyed by "x1,y1|x2,y2".
+ * Memory is proportional to the number of beeper cells and walls, not the world size.
+ */
+export class SparseGrid implements WorldGrid {
+  readonly kind = "sparse";
+
+  private readonly width: number;
+  private readonly height: number;
+  private beepers: Map<string, number> = new Map();
+  private walls: Set<string> = new Set();
+
+  // Undo log since saveInitialBeepers(): previous count of each changed cell
+  private undo: Map<string, number> | null = null;
+
+  constructor(width: number, height: number) {
+    this.width = width;
+    this.height = height;
+  }
+
+  getBeepers(x: number, y: number): number {
+    return this.beepers.get(positionKey(x, y)) ?? 0;
+  }
+
+  setBeepers(x: number, y: number, count: number): void {
+    const key = positionKey(x, y);
+    this.logWrite(key);
+    if (count > 0) {
+      this.beepers.set(key, count);
+    } else {
+      this.beepers.delete(key);
+    }
+  }
+
+  private logWrite(key: string): void {
+    if (this.undo && !this.undo.has(key)) {
+      this.undo.set(key, this.beepers.get(key) ?? 0);
+    }
+  }
+
+  hasWall(x: number, y: number, side: Side): boolean {
+    const { dx, dy } = SideOffsets[side];
+    return this.walls.has(wallKey(x, y, x + dx, y + dy));
+  }
+
+  addWall(x: number, y: number, side: Side): void {
+    const { dx, dy } = SideOffsets[side];
+    this.walls.add(wallKey(x, y, x + dx, y + dy));
+  }
+
+  removeWall(x: number, y: number, side: Side): void {
+    const { dx, dy } = SideOffsets[side];
+    this.walls.delete(wallKey(x, y, x + dx, y + dy));
+  }
+
+  isBlocked(x: number, y: number, side: Side): boolean {
+    const { dx, dy } = SideOffsets[side];
+    const nx = x + dx;
+    const ny = y + dy;
+    // Out of bounds is blocked
+    if (nx < 1 || nx > this.width || ny < 1 || ny > this.height) {
+      return true;
+    }
+    return this.walls.has(wallKey(x, y, nx, ny));
+  }
+
+  forEachBeeper(callback: (x: number, y: number, count: number) => void): void {
+    for (const [key, count] of this.beepers) {
+      const [x, y] = key.split(",").map(Number);
+      callback(x, y, count);
+    }
+  }
+
+  forEachWall(callback: (x1: number, y1: number, x2: number, y2: number) => void): void {
+    for (const key of this.walls) {
+      const [fromStr, toStr] = key.split("|");
+      const [fromX, fromY] = fromStr.split(",").map(Number);
+      const [toX, toY] = toStr.split(",").map(Number);
+      callback(fromX, fromY, toX, toY);
+    }
+  }
+
+  clearBeepers(): void {
+    for (const key of this.beepers.keys()) {
+      this.logWrite(key);
+    }
+    this.beepers = new Map();
+  }
+
+  saveInitialBeepers(): void {
+    this.undo = new Map();
+  }
+
+  resetBeepers(onChange?: (x: number, y: number, from: number, to: number) => void): void {
+    if (!this.undo) {
+      this.beepers = new Map();
+      return;
+    }
+
+    for (const [key, to] of this.undo) {
+      const from = this.beepers.get(key) ?? 0;
+      if (from === to) {
+        continue;
+      }
+      if (to > 0) {
+        this.beepers.set(key, to);
+      } else {
+        this.beepers.delete(key);
+      }
+      if (onChange) {
+        const [x, y] = key.split(",").map(Number);
+        onChange(x, y, from, to);
+      }
+    }
+    this.undo.clear();
+  }
+}
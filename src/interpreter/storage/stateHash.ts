@@ -0,0 +1,63 @@
+/**
+ * Zobrist-style state hashing.
+ *
+ * A state hash is the XOR of one key per state component (a beeper cell, a
+ * stack slot, ...), so updating a component costs two XORs: remove the old key
+ * and add the new one. Keys are derived from the component by a mixing function
+ * instead of a random table, which keeps memory constant for any world size.
+ *
+ * Two independent 32-bit lanes are kept and combined into one 53-bit number
+ * that can be compared with ===.
+ */
+
+/**
+ * Independent hash lanes.
+ */
+export enum HashLane {
+  Lo = 0,
+  Hi = 1,
+}
+
+/**
+ * Kind of state component a key stands for, so equal coordinates in different
+ * components never produce the same key.
+ */
+export enum HashKind {
+  Beeper = 1,
+  Karel,
+  ProgramCounter,
+  CallStack,
+  Counter,
+}
+
+const LANE_SEEDS = [0x243f6a88, 0x85a308d3];
+
+/**
+ * MurmurHash3 32-bit finalizer. Returns a signed 32-bit value: unsigned ones
+ * above 2^31 are boxed as heap numbers, which would allocate on every step.
+ */
+function mix32(h: number): number {
+  h ^= h >>> 16;
+  h = Math.imul(h, 0x85ebca6b);
+  h ^= h >>> 13;
+  h = Math.imul(h, 0xc2b2ae35);
+  h ^= h >>> 16;
+  return h;
+}
+
+/**
+ * Key of one state component in the given lane.
+ */
+export function hashKey(lane: HashLane, kind: HashKind, a: number, b: number, c: number): number {
+  let h = mix32(LANE_SEEDS[lane] ^ kind);
+  h = mix32(h ^ Math.imul(a, 0x9e3779b1));
+  h = mix32(h ^ Math.imul(b, 0x85ebca77));
+  return mix32(h ^ Math.imul(c, 0xc2b2ae3d));
+}
+
+/**
+ * Combine both lanes into a single number (53 significant bits).
+ */
+export function combineLanes(lo: number, hi: number): number {
+  return (hi >>> 11) * 0x100000000 + (lo >>> 0);
+}
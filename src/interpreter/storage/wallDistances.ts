@@ -0,0 +1,91 @@
+/**
+ * Precomputed distance-to-wall tables.
+ */
+
+import type { WorldGrid } from "@/interpreter/storage/worldGrid";
+import { Side } from "@/interpreter/storage/sides";
+
+type DistanceTable = Uint16Array | Uint32Array;
+
+/**
+ * For every cell and side, the number of cells that can be crossed through that
+ * side before a wall or the border blocks the way.
+ *
+ * Each side's table is built on first use in one pass over the grid, so a world
+ * that only ever runs move-to-wall eastwards pays for one table.
+ * The tables are a snapshot: rebuild after walls change.
+ */
+export class WallDistances {
+  private readonly grid: WorldGrid;
+  private readonly width: number;
+  private readonly height: number;
+  private readonly tables: Map<Side, DistanceTable> = new Map();
+
+  constructor(grid: WorldGrid, width: number, height: number) {
+    this.grid = grid;
+    this.width = width;
+    this.height = height;
+  }
+
+  /**
+   * Distance from cell (x, y) to the next wall through `side`.
+   */
+  get(x: number, y: number, side: Side): number {
+    let table = this.tables.get(side);
+    if (!table) {
+      table = this.build(side);
+      this.tables.set(side, table);
+    }
+    return table[(y - 1) * this.width + (x - 1)];
+  }
+
+  private build(side: Side): DistanceTable {
+    const { grid, width, height } = this;
+    const table =
+      Math.max(width, height) <= 0xffff
+        ? new Uint16Array(width * height)
+        : new Uint32Array(width * height);
+
+    // Scan each row or column starting from the cell nearest the border
+    // on `side`, so the neighbour's distance is always known.
+    switch (side) {
+      case Side.East:
+        for (let y = 1; y <= height; y++) {
+          const row = (y - 1) * width;
+          for (let x = width; x >= 1; x--) {
+            const i = row + x - 1;
+            table[i] = grid.isBlocked(x, y, side) ? 0 : table[i + 1] + 1;
+          }
+        }
+        break;
+      case Side.West:
+        for (let y = 1; y <= height; y++) {
+          const row = (y - 1) * width;
+          for (let x = 1; x <= width; x++) {
+            const i = row + x - 1;
+            table[i] = grid.isBlocked(x, y, side) ? 0 : table[i - 1] + 1;
+          }
+        }
+        break;
+      case Side.North:
+        for (let y = height; y >= 1; y--) {
+          const row = (y - 1) * width;
+          for (let x = 1; x <= width; x++) {
+            const i = row + x - 1;
+            table[i] = grid.isBlocked(x, y, side) ? 0 : table[i + width] + 1;
+          }
+        }
+        break;
+      case Side.South:
+        for (let y = 1; y <= height; y++) {
+          const row = (y - 1) * width;
+          for (let x = 1; x <= width; x++) {
+            const i = row + x - 1;
+            table[i] = grid.isBlocked(x, y, side) ? 0 : table[i - width] + 1;
+          }
+        }
+        break;
+    }
+    return table;
+  }
+}
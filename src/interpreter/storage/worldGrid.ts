@@ -0,0 +1,109 @@
+/**
+ * Storage backends for world walls and beepers.
+ *
+ * World keeps its public API position-based; a WorldGrid stores the cell data.
+ * DenseGrid uses typed arrays indexed by cell, SparseGrid uses string-keyed
+ * collections and is kept for very sparse or huge worlds.
+ */
+
+import type { KarelMap } from "@/interpreter/world";
+import { DenseGrid } from "@/interpreter/storage/denseGrid";
+import { SparseGrid } from "@/interpreter/storage/sparseGrid";
+import { Side } from "@/interpreter/storage/sides";
+
+/**
+ * Cell storage used by World.
+ * Coordinates are 1-based; walls are addressed by a cell and one of its sides.
+ */
+export interface WorldGrid {
+  readonly kind: "dense" | "sparse";
+
+  getBeepers(x: number, y: number): number;
+  setBeepers(x: number, y: number, count: number): void;
+
+  hasWall(x: number, y: number, side: Side): boolean;
+  addWall(x: number, y: number, side: Side): void;
+  removeWall(x: number, y: number, side: Side): void;
+
+  /**
+   * Check if leaving cell (x, y) through `side` is blocked by a wall or the world border.
+   */
+  isBlocked(x: number, y: number, side: Side): boolean;
+
+  forEachBeeper(callback: (x: number, y: number, count: number) => void): void;
+  forEachWall(callback: (x1: number, y1: number, x2: number, y2: number) => void): void;
+
+  /**
+   * Remove every beeper (the saved initial beepers are kept).
+   */
+  clearBeepers(): void;
+
+  /**
+   * Remember the current beepers as the state restored by resetBeepers().
+   * Nothing is copied: from now on, the first write to each cell logs its
+   * previous count.
+   */
+  saveInitialBeepers(): void;
+
+  /**
+   * Restore the beepers saved by saveInitialBeepers() by undoing the logged
+   * writes, in time proportional to the number of changed cells.
+   * `onChange` is called for every cell whose count changes.
+   */
+  resetBeepers(onChange?: (x: number, y: number, from: number, to: number) => void): void;
+}
+
+/**
+ * Worlds with more cells than this always use the sparse backend.
+ */
+const DENSE_MAX_CELLS = 1 << 22;
+
+/**
+ * Worlds this large use the sparse backend when almost every cell is empty.
+ */
+const SPARSE_MIN_CELLS = 1 << 20;
+const SPARSE_CELLS_PER_FEATURE = 4096;
+
+/**
+ * Largest beeper count a dense cell can hold.
+ */
+const DENSE_MAX_BEEPERS = 0xffffffff;
+
+/**
+ * Check if every beeper count of a run on this map fits a Uint32Array cell.
+ * Beepers only move between the bag and the cells, so no cell can ever hold
+ * more than their total.
+ */
+export function beeperCountsFitUint32(map: KarelMap): boolean {
+  let total = map.karel.beepers ?? 0;
+  const countsFit = map.beepers.every((b) => {
+    total += b.count;
+    return Number.isInteger(b.count) && b.count >= 0;
+  });
+  return countsFit && Number.isInteger(total) && total <= DENSE_MAX_BEEPERS;
+}
+
+/**
+ * Pick a storage backend for a map.
+ */
+export function createWorldGrid(map: KarelMap): WorldGrid {
+  const { width, height } = map.dimensions;
+  const cells = width * height;
+  const features = map.beepers.length + map.walls.length;
+
+  // Beepers outside the grid can only be represented by the sparse backend
+  const beepersInBounds = map.beepers.every(
+    (b) => b.x >= 1 && b.x <= width && b.y >= 1 && b.y <= height
+  );
+
+  // So can counts a Uint32Array cell would wrap
+  const countsInRange = beeperCountsFitUint32(map);
+
+  const veryLarge = cells > DENSE_MAX_CELLS;
+  const verySparse = cells >= SPARSE_MIN_CELLS && features * SPARSE_CELLS_PER_FEATURE < cells;
+
+  if (!beepersInBounds || !countsInRange || veryLarge || verySparse) {
+    return new SparseGrid(width, height);
+  }
+  return new DenseGrid(width, height);
+}
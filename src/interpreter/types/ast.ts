@@ -2,6 +2,8 @@
  * AST (Abstract Syntax Tree) node definitions.
  */
 
+import type { Predicate, BuiltIn } from "@/interpreter/parsing/constants";
+
 /**
  * AST Node types for the parsed program.
  */
@@ -13,7 +15,8 @@ export type ASTNode =
   | WhileNode
   | IterateNode
   | InstructionCallNode
-  | BlockNode;
+  | BlockNode
+  | FoldedNode;
 
 export interface ProgramNode {
   type: "program";
@@ -41,6 +44,7 @@ export interface BlockNode {
 export interface IfNode {
   type: "if";
   condition: string;
+  predicate: Predicate;
   thenBranch: BlockNode;
   elseBranch?: BlockNode;
   line: number;
@@ -49,6 +53,7 @@ export interface IfNode {
 export interface WhileNode {
   type: "while";
   condition: string;
+  predicate: Predicate;
   body: BlockNode;
   line: number;
 }
@@ -64,4 +69,28 @@ export interface InstructionCallNode {
   type: "call";
   name: string;
   line: number;
+  /** Set by resolveCalls() before the program is compiled. */
+  target?: CallTarget;
 }
+
+/**
+ * Straight-line code folded by optimizeAst() (the parser never produces it):
+ * turns Karel left `turns` times and stands for the `steps` steps and
+ * `iterations` VM instructions the original statements ran.
+ */
+export interface FoldedNode {
+  type: "folded";
+  turns: number;
+  steps: number;
+  iterations: number;
+  /** Source line of the last step, or 0 when it has no steps. */
+  line: number;
+}
+
+/**
+ * What an instruction call runs: a built-in, or the custom instruction at
+ * an index of ProgramNode.definitions.
+ */
+export type CallTarget =
+  | { kind: "builtin"; builtIn: BuiltIn }
+  | { kind: "procedure"; index: number };
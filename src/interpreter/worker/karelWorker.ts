@@ -0,0 +1,116 @@
+/**
+ * Interpreter worker entry point.
+ *
+ * Runs a parsed program and its world on a worker_thread so long batches never
+ * block the extension host. Built as a separate webpack entry (dist/karelWorker.js).
+ */
+
+import { parentPort, workerData } from "worker_threads";
+import { World } from "@/interpreter/world";
+import { Interpreter } from "@/interpreter/execution/interpreter";
+import { RuntimeError } from "@/interpreter/types/errors";
+import {
+  ControlSlot,
+  WorkerInitData,
+  WorkerRequest,
+  WorkerResponse,
+} from "@/interpreter/worker/protocol";
+
+const port = parentPort!;
+const control = new Int32Array((workerData as WorkerInitData).control);
+
+let world: World | null = null;
+let interpreter: Interpreter | null = null;
+
+function post(message: WorkerResponse): void {
+  port.postMessage(message);
+}
+
+function postState(event: "step" | "slice" | "reset", line: number): void {
+  if (!world) {
+    return;
+  }
+  const delta = world.takeChanges();
+  post({
+    type: "state",
+    event,
+    ...(delta ? { delta } : { world: world.captureState() }),
+    line,
+    isModified: world.isModified,
+  });
+}
+
+function postError(error: unknown): void {
+  if (error instanceof RuntimeError) {
+    post({ type: "error", message: error.message, line: error.line });
+  } else if (error instanceof Error) {
+    post({ type: "error", message: error.message });
+  } else {
+    post({ type: "error", message: String(error) });
+  }
+}
+
+function load(request: Extract<WorkerRequest, { type: "load" }>): void {
+  world = World.fromJSON(request.map);
+  interpreter = new Interpreter(world);
+  interpreter.setSpeed(request.speed);
+  interpreter.setTurbo(request.turbo);
+  interpreter.setMaxRecursionDepth(request.maxRecursionDepth);
+  interpreter.setBudget(request.budget);
+
+  interpreter.onStep = (line) => postState("step", line);
+  interpreter.onSlice = (line) => postState("slice", line);
+  interpreter.onComplete = () => post({ type: "complete" });
+  interpreter.onError = (error) => postError(error);
+  interpreter.onBudgetExhausted = (message) => post({ type: "paused", message });
+  interpreter.interruptRequested = () => Atomics.load(control, ControlSlot.Interrupt) !== 0;
+
+  post({ type: "loaded", diagnostics: interpreter.load(request.source) });
+}
+
+async function handle(request: WorkerRequest): Promise<void> {
+  if (request.type === "load") {
+    load(request);
+    return;
+  }
+  if (!interpreter) {
+    post({ type: "error", message: "Interpreter not initialized" });
+    return;
+  }
+
+  switch (request.type) {
+    case "step": {
+      let hasMore = false;
+      try {
+        hasMore = interpreter.step();
+      } finally {
+        post({ type: "stepped", hasMore });
+      }
+      break;
+    }
+    case "run":
+      try {
+        await interpreter.run();
+      } finally {
+        post({ type: "finished" });
+      }
+      break;
+    case "stop":
+      interpreter.stop();
+      break;
+    case "reset":
+      interpreter.reset();
+      postState("reset", 0);
+      break;
+    case "speed":
+      interpreter.setSpeed(request.ms);
+      break;
+    case "extendBudget":
+      interpreter.extendBudget();
+      break;
+  }
+}
+
+port.on("message", (request: WorkerRequest) => {
+  handle(request).catch((error) => postError(error));
+});
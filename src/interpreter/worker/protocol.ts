@@ -0,0 +1,67 @@
+/**
+ * Message protocol between the extension host and the interpreter worker.
+ */
+
+import type { KarelMap, WorldDelta, WorldSnapshot } from "@/interpreter/world";
+import type { Diagnostic } from "@/interpreter/types/errors";
+import type { ExecutionBudget } from "@/interpreter/execution/budget";
+
+/**
+ * Data passed to the worker when it is created.
+ */
+export interface WorkerInitData {
+  /** SharedArrayBuffer backing an Int32Array of ControlSlot entries. */
+  control: SharedArrayBuffer;
+}
+
+/**
+ * Slots of the shared control array.
+ * The worker polls these inside long batches, so they take effect without
+ * waiting for the worker's message queue.
+ */
+export enum ControlSlot {
+  Interrupt = 0,
+}
+
+export const CONTROL_SLOTS = 1;
+
+/**
+ * Requests sent from the extension host to the worker.
+ */
+export type WorkerRequest =
+  | {
+      type: "load";
+      map: KarelMap;
+      source: string;
+      speed: number;
+      turbo: boolean;
+      maxRecursionDepth: number;
+      budget: ExecutionBudget;
+    }
+  | { type: "step" }
+  | { type: "run" }
+  | { type: "stop" }
+  | { type: "reset" }
+  | { type: "speed"; ms: number }
+  | { type: "extendBudget" };
+
+/**
+ * Messages sent from the worker back to the extension host.
+ */
+export type WorkerResponse =
+  | { type: "loaded"; diagnostics: Diagnostic[] }
+  | {
+      type: "state";
+      event: "step" | "slice" | "reset";
+      /** Changes since the previous state message, when available. */
+      delta?: WorldDelta;
+      /** Karel and every beeper, sent when no delta is available (walls never change). */
+      world?: WorldSnapshot;
+      line: number;
+      isModified: boolean;
+    }
+  | { type: "complete" }
+  | { type: "error"; message: string; line?: number }
+  | { type: "paused"; message: string }
+  | { type: "stepped"; hasMore: boolean }
+  | { type: "finished" };
@@ -9,6 +9,12 @@
 
 import { Karel, Position, Direction, DirectionVectors } from "@/interpreter/karel";
 import { ErrorMessages } from "@/i18n/messages";
+import { WorldGrid, createWorldGrid } from "@/interpreter/storage/worldGrid";
+import type { DenseGrid } from "@/interpreter/storage/denseGrid";
+import { Side, sideTowards } from "@/interpreter/storage/sides";
+import { WallDistances } from "@/interpreter/storage/wallDistances";
+import { HashKind, HashLane, hashKey } from "@/interpreter/storage/stateHash";
+import { Predicate, PREDICATES } from "@/interpreter/parsing/constants";
 
 /**
  * Represents a wall between two adjacent cells.
@@ -52,24 +58,29 @@ export interface KarelMap {
 }
 
 /**
- * Generates a unique key for a wall between two positions.
- * Normalizes the order so (A,B) and (B,A) produce the same key.
+ * Changes since the last call to World.takeChanges().
+ * Beeper entries carry the cell's current count (0 when emptied).
  */
-function wallKey(from: Position, to: Position): string {
-  // Sort positions to ensure consistent key regardless of direction
-  if (from.x < to.x || (from.x === to.x && from.y < to.y)) {
-    return `${from.x},${from.y}|${to.x},${to.y}`;
-  }
-  return `${to.x},${to.y}|${from.x},${from.y}`;
+export interface WorldDelta {
+  karel: KarelMap["karel"];
+  beepers: BeeperStack[];
 }
 
 /**
- * Generates a unique key for a position.
+ * Karel and the beepers at one point of a run.
+ * Walls are not included since programs cannot change them.
  */
-function positionKey(pos: Position): string {
-  return `${pos.x},${pos.y}`;
+export interface WorldSnapshot {
+  karel: KarelMap["karel"];
+  beepers: BeeperStack[];
 }
 
+/**
+ * Beeper changes kept before the log gives up and asks for a full snapshot.
+ * Bounds memory when nobody drains the log (e.g. headless runs).
+ */
+const MAX_LOGGED_CHANGES = 4096;
+
 /**
  * Check if two positions are adjacent (Manhattan distance = 1).
  */
@@ -79,20 +90,49 @@ function areAdjacent(a: Position, b: Position): boolean {
   return (dx === 1 && dy === 0) || (dx === 0 && dy === 1);
 }
 
+/**
+ * Side of Karel's cell in front of, left of and right of each facing.
+ */
+const FrontSides: Record<Direction, Side> = {
+  [Direction.North]: Side.North,
+  [Direction.West]: Side.West,
+  [Direction.South]: Side.South,
+  [Direction.East]: Side.East,
+};
+
+const LeftSides: Record<Direction, Side> = {
+  [Direction.North]: Side.West,
+  [Direction.West]: Side.South,
+  [Direction.South]: Side.East,
+  [Direction.East]: Side.North,
+};
+
+const RightSides: Record<Direction, Side> = {
+  [Direction.North]: Side.East,
+  [Direction.East]: Side.South,
+  [Direction.South]: Side.West,
+  [Direction.West]: Side.North,
+};
+
 /**
  * Karel's World - manages the environment state.
  */
 export class World {
   private _dimensions: Dimensions;
   private _karel: Karel;
-  private _beepers: Map<string, number>; // positionKey -> count
-  private _walls: Set<string>; // wallKey set
+  private _grid: WorldGrid; // walls and beepers
+  private _wallDistances: WallDistances | null = null; // built on demand, dense grids only
+  private _beeperHash: Uint32Array = new Uint32Array(2); // Zobrist hash of the beepers, per lane
 
-  // Store initial state for reset
+  // Store initial state for reset (initial beepers are kept by the grid)
   private _initialKarel: Karel;
-  private _initialBeepers: Map<string, number>;
   private _isModified: boolean = false;
 
+  // Change log for incremental view updates
+  private _changedBeepers: number[] = []; // x, y pairs
+  private _needsFullSync: boolean = true;
+  private _wallsChanged: boolean = true; // since the last takeWallChanges()
+
   constructor(map: KarelMap) {
     this._dimensions = { ...map.dimensions };
 
@@ -100,17 +140,17 @@ export class World {
     this._karel = Karel.fromJSON(map.karel);
     this._initialKarel = this._karel.clone();
 
+    // Pick dense or sparse storage for this map
+    this._grid = createWorldGrid(map);
+
     // Initialize beepers
-    this._beepers = new Map();
-    this._initialBeepers = new Map();
     for (const beeper of map.beepers) {
-      const key = positionKey({ x: beeper.x, y: beeper.y });
-      this._beepers.set(key, beeper.count);
-      this._initialBeepers.set(key, beeper.count);
+      this._grid.setBeepers(beeper.x, beeper.y, beeper.count);
     }
+    this._grid.saveInitialBeepers();
+    this.rehashBeepers();
 
     // Initialize walls with validation
-    this._walls = new Set();
     for (const wall of map.walls) {
       this.addWall(wall.from, wall.to);
     }
@@ -152,33 +192,43 @@ export class World {
     if (!areAdjacent(from, to)) {
       throw new Error(ErrorMessages.invalidWall(from.x, from.y, to.x, to.y));
     }
-    this._walls.add(wallKey(from, to));
+    this._grid.addWall(from.x, from.y, sideTowards(from.x, from.y, to.x, to.y));
+    this._wallDistances = null;
+    this._needsFullSync = true;
+    this._wallsChanged = true;
   }
 
   /**
    * Remove a wall between two cells.
    */
   removeWall(from: Position, to: Position): void {
-    this._walls.delete(wallKey(from, to));
+    if (areAdjacent(from, to)) {
+      this._grid.removeWall(from.x, from.y, sideTowards(from.x, from.y, to.x, to.y));
+      this._wallDistances = null;
+      this._needsFullSync = true;
+      this._wallsChanged = true;
+    }
   }
 
   /**
    * Check if there's a wall between two adjacent cells.
    */
   hasWall(from: Position, to: Position): boolean {
-    return this._walls.has(wallKey(from, to));
+    if (!areAdjacent(from, to)) {
+      return false;
+    }
+    return this._grid.hasWall(from.x, from.y, sideTowards(from.x, from.y, to.x, to.y));
   }
 
   /**
    * Check if a position is within world bounds.
    */
   isInBounds(pos: Position): boolean {
-    return (
-      pos.x >= 1 &&
-      pos.x <= this._dimensions.width &&
-      pos.y >= 1 &&
-      pos.y <= this._dimensions.height
-    );
+    return this.inBounds(pos.x, pos.y);
+  }
+
+  private inBounds(x: number, y: number): boolean {
+    return x >= 1 && x <= this._dimensions.width && y >= 1 && y <= this._dimensions.height;
   }
 
   /**
@@ -199,7 +249,8 @@ export class World {
    * Check if Karel's front is blocked.
    */
   frontIsBlocked(): boolean {
-    return this.isBlocked(this._karel.position, this._karel.frontPosition());
+    const karel = this._karel;
+    return this._grid.isBlocked(karel.x, karel.y, FrontSides[karel.facing]);
   }
 
   /**
@@ -213,7 +264,8 @@ export class World {
    * Check if Karel's left is blocked.
    */
   leftIsBlocked(): boolean {
-    return this.isBlocked(this._karel.position, this._karel.leftPosition());
+    const karel = this._karel;
+    return this._grid.isBlocked(karel.x, karel.y, LeftSides[karel.facing]);
   }
 
   /**
@@ -227,7 +279,8 @@ export class World {
    * Check if Karel's right is blocked.
    */
   rightIsBlocked(): boolean {
-    return this.isBlocked(this._karel.position, this._karel.rightPosition());
+    const karel = this._karel;
+    return this._grid.isBlocked(karel.x, karel.y, RightSides[karel.facing]);
   }
 
   /**
@@ -237,18 +290,62 @@ export class World {
     return !this.rightIsBlocked();
   }
 
+  /**
+   * Number of cells Karel can move forward before his front is blocked, at
+   * most `limit`. Dense worlds answer from a precomputed table; sparse ones
+   * walk the cells, so a limit bounds the walk.
+   */
+  distanceToWall(limit: number = Infinity): number {
+    const karel = this._karel;
+    const side = FrontSides[karel.facing];
+
+    if (this._grid.kind === "dense" && this.inBounds(karel.x, karel.y)) {
+      if (!this._wallDistances) {
+        this._wallDistances = new WallDistances(this._grid, this.width, this.height);
+      }
+      return Math.min(this._wallDistances.get(karel.x, karel.y, side), limit);
+    }
+
+    const { x: dx, y: dy } = DirectionVectors[karel.facing];
+    let x = karel.x;
+    let y = karel.y;
+    let distance = 0;
+    while (distance < limit && !this._grid.isBlocked(x, y, side)) {
+      x += dx;
+      y += dy;
+      distance++;
+    }
+    return distance;
+  }
+
+  /**
+   * Beeper counts and wall masks (Side bits, border included) of a dense
+   * world, indexed by (y - 1) * width + (x - 1). Null for sparse worlds.
+   * The arrays are live and must not be modified.
+   */
+  denseCells(): { beepers: Uint32Array; blocked: Uint8Array } | null {
+    return this._grid.kind === "dense" ? (this._grid as DenseGrid).cells : null;
+  }
+
   /**
    * Get beeper count at a position.
    */
   getBeepers(pos: Position): number {
-    return this._beepers.get(positionKey(pos)) ?? 0;
+    return this._grid.getBeepers(pos.x, pos.y);
+  }
+
+  /**
+   * Get beeper count at Karel's current position.
+   */
+  beepersAtKarel(): number {
+    return this._grid.getBeepers(this._karel.x, this._karel.y);
   }
 
   /**
    * Check if there's a beeper at Karel's current position.
    */
   nextToABeeper(): boolean {
-    return this.getBeepers(this._karel.position) > 0;
+    return this.beepersAtKarel() > 0;
   }
 
   /**
@@ -262,9 +359,7 @@ export class World {
    * Add beepers at a position.
    */
   addBeepers(pos: Position, count: number = 1): void {
-    const key = positionKey(pos);
-    const current = this._beepers.get(key) ?? 0;
-    this._beepers.set(key, current + count);
+    this.addBeepersAt(pos.x, pos.y, count);
   }
 
   /**
@@ -272,16 +367,21 @@ export class World {
    * Returns false if no beepers at position.
    */
   removeBeeper(pos: Position): boolean {
-    const key = positionKey(pos);
-    const current = this._beepers.get(key) ?? 0;
+    return this.removeBeeperAt(pos.x, pos.y);
+  }
+
+  private addBeepersAt(x: number, y: number, count: number): void {
+    this.setBeeperCount(x, y, this._grid.getBeepers(x, y) + count);
+    this.recordBeeperChange(x, y);
+  }
+
+  private removeBeeperAt(x: number, y: number): boolean {
+    const current = this._grid.getBeepers(x, y);
     if (current <= 0) {
       return false;
     }
-    if (current === 1) {
-      this._beepers.delete(key);
-    } else {
-      this._beepers.set(key, current - 1);
-    }
+    this.setBeeperCount(x, y, current - 1);
+    this.recordBeeperChange(x, y);
     return true;
   }
 
@@ -300,10 +400,10 @@ export class World {
   }
 
   /**
-   * Turn Karel left (counter-clockwise).
+   * Turn Karel left (counter-clockwise), `times` times.
    */
-  turnLeft(): void {
-    this._karel.turnLeft();
+  turnLeft(times: number = 1): void {
+    this._karel.turnLeft(times);
     this._isModified = true;
   }
 
@@ -312,9 +412,9 @@ export class World {
    * Throws if no beeper at position.
    */
   pickBeeper(): void {
-    const pos = this._karel.position;
-    if (!this.removeBeeper(pos)) {
-      throw new Error(ErrorMessages.noBeepersToPickUp(pos.x, pos.y));
+    const { x, y } = this._karel;
+    if (!this.removeBeeperAt(x, y)) {
+      throw new Error(ErrorMessages.noBeepersToPickUp(x, y));
     }
     this._karel.pickBeeper();
     this._isModified = true;
@@ -328,53 +428,140 @@ export class World {
     if (!this._karel.putBeeper()) {
       throw new Error(ErrorMessages.noBeepersInBag());
     }
-    this.addBeepers(this._karel.position);
+    this.addBeepersAt(this._karel.x, this._karel.y, 1);
+    this._isModified = true;
+  }
+
+  /**
+   * Move Karel forward `steps` cells at once.
+   * Throws if a wall is in the way, like the same number of move() calls would.
+   */
+  moveForward(steps: number): void {
+    if (this.distanceToWall(steps) < steps) {
+      throw new Error(ErrorMessages.moveBlocked());
+    }
+    this._karel.move(steps);
     this._isModified = true;
   }
 
+  /**
+   * Pick up `count` beepers at Karel's position at once.
+   * Throws if there are fewer, like the same number of pickBeeper() calls would.
+   */
+  pickBeepers(count: number): void {
+    const { x, y } = this._karel;
+    const current = this._grid.getBeepers(x, y);
+    if (count > current) {
+      throw new Error(ErrorMessages.noBeepersToPickUp(x, y));
+    }
+    if (count > 0) {
+      this.setBeeperCount(x, y, current - count);
+      this.recordBeeperChange(x, y);
+      this._karel.setBeepersInBag(this._karel.beepersInBag + count);
+      this._isModified = true;
+    }
+  }
+
+  /**
+   * Put down `count` beepers at Karel's position at once.
+   * Throws if the bag has fewer, like the same number of putBeeper() calls would.
+   */
+  putBeepers(count: number): void {
+    const bag = this._karel.beepersInBag;
+    if (count > bag) {
+      throw new Error(ErrorMessages.noBeepersInBag());
+    }
+    if (count > 0) {
+      this._karel.setBeepersInBag(bag - count);
+      this.addBeepersAt(this._karel.x, this._karel.y, count);
+      this._isModified = true;
+    }
+  }
+
+  /**
+   * Pick up every beeper at Karel's position.
+   * Returns the number of beepers picked up.
+   */
+  pickAllBeepers(): number {
+    const { x, y } = this._karel;
+    const count = this._grid.getBeepers(x, y);
+    if (count > 0) {
+      this.setBeeperCount(x, y, 0);
+      this.recordBeeperChange(x, y);
+      this._karel.setBeepersInBag(this._karel.beepersInBag + count);
+      this._isModified = true;
+    }
+    return count;
+  }
+
+  /**
+   * Put down every beeper in Karel's bag at his position.
+   * Returns the number of beepers put down.
+   */
+  putAllBeepers(): number {
+    const count = this._karel.beepersInBag;
+    if (count > 0) {
+      this._karel.setBeepersInBag(0);
+      this.addBeepersAt(this._karel.x, this._karel.y, count);
+      this._isModified = true;
+    }
+    return count;
+  }
+
   // ========== Condition Checking ==========
 
   /**
    * Evaluate a condition by name.
    */
   evaluateCondition(condition: string): boolean {
-    switch (condition.toLowerCase()) {
-      case "front-is-clear":
+    const predicate = PREDICATES[condition.toLowerCase()];
+    if (predicate === undefined) {
+      throw new Error(`Unknown condition: ${condition}`);
+    }
+    return this.evaluatePredicate(predicate);
+  }
+
+  /**
+   * Evaluate a condition resolved by the parser.
+   */
+  evaluatePredicate(predicate: Predicate): boolean {
+    switch (predicate) {
+      case Predicate.FrontIsClear:
         return this.frontIsClear();
-      case "front-is-blocked":
+      case Predicate.FrontIsBlocked:
         return this.frontIsBlocked();
-      case "left-is-clear":
+      case Predicate.LeftIsClear:
         return this.leftIsClear();
-      case "left-is-blocked":
+      case Predicate.LeftIsBlocked:
         return this.leftIsBlocked();
-      case "right-is-clear":
+      case Predicate.RightIsClear:
         return this.rightIsClear();
-      case "right-is-blocked":
+      case Predicate.RightIsBlocked:
         return this.rightIsBlocked();
-      case "next-to-a-beeper":
+      case Predicate.NextToABeeper:
         return this.nextToABeeper();
-      case "not-next-to-a-beeper":
+      case Predicate.NotNextToABeeper:
         return !this.nextToABeeper();
-      case "facing-north":
+      case Predicate.FacingNorth:
         return this._karel.isFacing(Direction.North);
-      case "not-facing-north":
+      case Predicate.NotFacingNorth:
         return !this._karel.isFacing(Direction.North);
-      case "facing-south":
+      case Predicate.FacingSouth:
         return this._karel.isFacing(Direction.South);
-      case "not-facing-south":
+      case Predicate.NotFacingSouth:
         return !this._karel.isFacing(Direction.South);
-      case "facing-east":
+      case Predicate.FacingEast:
         return this._karel.isFacing(Direction.East);
-      case "not-facing-east":
+      case Predicate.NotFacingEast:
         return !this._karel.isFacing(Direction.East);
-      case "facing-west":
+      case Predicate.FacingWest:
         return this._karel.isFacing(Direction.West);
-      case "not-facing-west":
+      case Predicate.NotFacingWest:
         return !this._karel.isFacing(Direction.West);
-      case "beeper-in-bag":
+      case Predicate.BeeperInBag:
         return this.beeperInBag();
       default:
-        throw new Error(`Unknown condition: ${condition}`);
+        throw new Error(`Unknown condition: ${predicate}`);
     }
   }
 
@@ -382,18 +569,147 @@ export class World {
 
   /**
    * Reset world to initial state.
+   * Only the beeper cells changed since the world was created are touched.
    */
   reset(): void {
     // Reset Karel
     this._karel = this._initialKarel.clone();
 
-    // Reset beepers
-    this._beepers = new Map(this._initialBeepers);
+    // Undo beeper changes, keeping the hash and the change log up to date
+    this._grid.resetBeepers((x, y, from, to) => {
+      this.toggleBeeperKey(x, y, from);
+      this.toggleBeeperKey(x, y, to);
+      this.recordBeeperChange(x, y);
+    });
 
     // Clear modified flag
     this._isModified = false;
   }
 
+  /**
+   * Capture Karel and the beepers, to be restored later with loadState().
+   */
+  captureState(): WorldSnapshot {
+    return { karel: this._karel.toJSON(), beepers: this.getAllBeepers() };
+  }
+
+  /**
+   * Replace Karel and the beepers with a state computed elsewhere (e.g. by a
+   * worker) or captured earlier. Walls and the initial state used by reset()
+   * are kept.
+   */
+  loadState(state: WorldSnapshot, isModified: boolean = true): void {
+    this._karel = Karel.fromJSON(state.karel);
+    this._grid.clearBeepers();
+    for (const beeper of state.beepers) {
+      this._grid.setBeepers(beeper.x, beeper.y, beeper.count);
+    }
+    this.rehashBeepers();
+    this._isModified = isModified;
+    this._needsFullSync = true;
+  }
+
+  /**
+   * Apply a delta produced by another World's takeChanges() (e.g. in a worker).
+   * The applied cells are recorded in this world's own change log.
+   */
+  applyDelta(delta: WorldDelta, isModified: boolean = true): void {
+    this._karel = Karel.fromJSON(delta.karel);
+    for (const beeper of delta.beepers) {
+      this.setBeeperCount(beeper.x, beeper.y, beeper.count);
+      this.recordBeeperChange(beeper.x, beeper.y);
+    }
+    this._isModified = isModified;
+  }
+
+  // ========== State Hashing ==========
+
+  /**
+   * Store a beeper count, keeping the beeper hash up to date.
+   */
+  private setBeeperCount(x: number, y: number, count: number): void {
+    const current = this._grid.getBeepers(x, y);
+    this.toggleBeeperKey(x, y, current);
+    this.toggleBeeperKey(x, y, count);
+    this._grid.setBeepers(x, y, count);
+  }
+
+  private toggleBeeperKey(x: number, y: number, count: number): void {
+    // Empty cells contribute nothing, so the hash does not depend on the backend
+    if (count > 0) {
+      this._beeperHash[HashLane.Lo] ^= hashKey(HashLane.Lo, HashKind.Beeper, x, y, count);
+      this._beeperHash[HashLane.Hi] ^= hashKey(HashLane.Hi, HashKind.Beeper, x, y, count);
+    }
+  }
+
+  /**
+   * Recompute the beeper hash from scratch (after bulk changes).
+   */
+  private rehashBeepers(): void {
+    this._beeperHash.fill(0);
+    this._grid.forEachBeeper((x, y, count) => this.toggleBeeperKey(x, y, count));
+  }
+
+  /**
+   * One lane of the hash of Karel's pose, bag and every beeper.
+   * Walls are not included since programs cannot change them.
+   */
+  stateHash(lane: HashLane): number {
+    const karel = this._karel;
+    const pose = karel.beepersInBag * 16 + FrontSides[karel.facing];
+    return this._beeperHash[lane] ^ hashKey(lane, HashKind.Karel, karel.x, karel.y, pose);
+  }
+
+  // ========== Change Tracking ==========
+
+  private recordBeeperChange(x: number, y: number): void {
+    if (this._needsFullSync) {
+      return;
+    }
+    if (this._changedBeepers.length >= MAX_LOGGED_CHANGES * 2) {
+      this._needsFullSync = true;
+      this._changedBeepers.length = 0;
+      return;
+    }
+    this._changedBeepers.push(x, y);
+  }
+
+  /**
+   * Drain the change log: Karel's pose and bag plus every beeper cell changed
+   * since the previous call. Returns null when a full snapshot is needed instead
+   * (first call, after reset/loadState, wall edits or log overflow).
+   */
+  takeChanges(): WorldDelta | null {
+    const changed = this._changedBeepers;
+
+    if (this._needsFullSync) {
+      this._needsFullSync = false;
+      changed.length = 0;
+      return null;
+    }
+
+    const beepers: BeeperStack[] = [];
+    for (let i = 0; i < changed.length; i += 2) {
+      const x = changed[i];
+      const y = changed[i + 1];
+      beepers.push({ x, y, count: this._grid.getBeepers(x, y) });
+    }
+    changed.length = 0;
+
+    return { karel: this._karel.toJSON(), beepers };
+  }
+
+  /**
+   * Whether walls were added or removed since the previous call (true on the
+   * first one). When takeChanges() returns null for any other reason, Karel
+   * and the beepers (captureState()) are all a view needs.
+   */
+  takeWallChanges(): boolean {
+    const changed = this._wallsChanged;
+    this._wallsChanged = false;
+    return changed;
+  }
+
   /**
    * Check if world has been modified from initial state.
    */
@@ -406,10 +722,9 @@ export class World {
    */
   getAllBeepers(): BeeperStack[] {
     const result: BeeperStack[] = [];
-    for (const [key, count] of this._beepers) {
-      const [x, y] = key.split(",").map(Number);
+    this._grid.forEachBeeper((x, y, count) => {
       result.push({ x, y, count });
-    }
+    });
     return result;
   }
 
@@ -418,15 +733,12 @@ export class World {
    */
   getAllWalls(): Wall[] {
     const result: Wall[] = [];
-    for (const key of this._walls) {
-      const [fromStr, toStr] = key.split("|");
-      const [fromX, fromY] = fromStr.split(",").map(Number);
-      const [toX, toY] = toStr.split(",").map(Number);
+    this._grid.forEachWall((fromX, fromY, toX, toY) => {
       result.push({
         from: { x: fromX, y: fromY },
         to: { x: toX, y: toY },
       });
-    }
+    });
     return result;
   }
 
@@ -61,10 +61,12 @@ export class WebviewProvider {
 
   /**
    * Load a world into the visualizer.
+   * Hides the timeline, which belongs to the previously shown run.
    */
   public loadWorld(world: World): void {
     this.world = world;
-    this.updateView();
+    this.postFullWorld();
+    this.panel.webview.postMessage({ type: "hideTimeline" });
   }
 
   /**
@@ -72,17 +74,52 @@ export class WebviewProvider {
    */
   public loadMap(map: KarelMap): void {
     this.world = World.fromJSON(map);
-    this.updateView();
+    this.postFullWorld();
   }
 
   /**
    * Update the visualization.
+   * Sends only the world's changes since the last update when possible, and
+   * otherwise Karel and the beepers: walls only when they changed.
    */
   public updateView(): void {
     if (!this.world) {
       return;
     }
 
+    const delta = this.world.takeChanges();
+    if (!delta) {
+      if (this.world.takeWallChanges()) {
+        this.postFullWorld();
+      } else {
+        this.panel.webview.postMessage({
+          type: "worldState",
+          data: this.world.captureState(),
+          isModified: this.world.isModified,
+        });
+      }
+      return;
+    }
+
+    this.panel.webview.postMessage({
+      type: "worldDelta",
+      data: delta,
+      isModified: this.world.isModified,
+    });
+  }
+
+  /**
+   * Send a full snapshot of the world, walls included (on load, or after wall edits).
+   */
+  private postFullWorld(): void {
+    if (!this.world) {
+      return;
+    }
+
+    // Start a fresh change log from this snapshot
+    this.world.takeChanges();
+    this.world.takeWallChanges();
+
     this.panel.webview.postMessage({
       type: "updateWorld",
       data: this.world.toJSON(),
@@ -100,6 +137,25 @@ export class WebviewProvider {
     });
   }
 
+  /**
+   * Show the timeline of a precomputed run or replayed trace.
+   * @param total - Number of steps
+   * @param end - How the run ends, flagged at the end of the timeline
+   */
+  public showTimeline(
+    total: number,
+    end: { status: "completed" | "error" | "stopped"; message?: string }
+  ): void {
+    this.panel.webview.postMessage({ type: "timeline", total, end });
+  }
+
+  /**
+   * Move the timeline marker.
+   */
+  public setTimelinePosition(step: number): void {
+    this.panel.webview.postMessage({ type: "timelinePosition", step });
+  }
+
   /**
    * Show execution status.
    */
@@ -128,6 +184,12 @@ export class WebviewProvider {
       case "step":
         vscode.commands.executeCommand("vs-karel.step");
         break;
+      case "stepBack":
+        vscode.commands.executeCommand("vs-karel.stepBack");
+        break;
+      case "seekTimeline":
+        vscode.commands.executeCommand("vs-karel.seekTimeline", message.data);
+        break;
       case "stop":
         vscode.commands.executeCommand("vs-karel.stop");
         break;
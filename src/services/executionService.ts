@@ -4,42 +4,99 @@
  */
 
 import * as vscode from "vscode";
-import { Interpreter, World, RuntimeError } from "@/interpreter";
+import {
+  Interpreter,
+  World,
+  RuntimeError,
+  Diagnostic,
+  DEFAULT_MAX_RECURSION_DEPTH,
+  DEFAULT_EXECUTION_BUDGET,
+  ExecutionBudget,
+} from "@/interpreter";
+import { WorkerExecutionBackend } from "@/services/workerExecutionBackend";
 
 export class ExecutionService {
   private interpreter: Interpreter | null = null;
+  private worker: WorkerExecutionBackend | null = null;
   private isRunning: boolean = false;
+  private speed: number = 500;
+  private turbo: boolean = false;
+  private maxRecursionDepth: number = DEFAULT_MAX_RECURSION_DEPTH;
+  private budget: ExecutionBudget = { ...DEFAULT_EXECUTION_BUDGET };
 
   // Callbacks
   public onStep?: (line: number) => void;
+  public onSlice?: (line: number) => void;
   public onComplete?: () => void;
   public onError?: (error: RuntimeError) => void;
+  public onBudgetExhausted?: (message: string) => void;
+
+  /**
+   * Step and control budget from the vs-karel settings
+   */
+  static configuredBudget(): ExecutionBudget {
+    const config = vscode.workspace.getConfiguration("vs-karel");
+    return {
+      steps: config.get("stepBudget", DEFAULT_EXECUTION_BUDGET.steps),
+      control: config.get("controlBudget", DEFAULT_EXECUTION_BUDGET.control),
+    };
+  }
 
   /**
    * Create and initialize interpreter
    */
   createInterpreter(world: World): Interpreter {
+    this.disposeWorker();
     this.interpreter = new Interpreter(world);
     this.setupCallbacks();
     return this.interpreter;
   }
 
   /**
-   * Get current interpreter instance
+   * Create a worker_thread backend. The world receives the worker's state
+   * snapshots so views can keep reading it.
+   * @param scriptPath - Path of the bundled worker script (dist/karelWorker.js)
+   */
+  createWorker(world: World, scriptPath: string): WorkerExecutionBackend {
+    this.disposeWorker();
+    this.interpreter = null;
+    this.worker = new WorkerExecutionBackend(world, scriptPath);
+    this.setupCallbacks();
+    return this.worker;
+  }
+
+  /**
+   * Get current interpreter instance (null when running in a worker)
    */
   getInterpreter(): Interpreter | null {
     return this.interpreter;
   }
 
+  /**
+   * Check if execution runs on a worker_thread
+   */
+  usesWorker(): boolean {
+    return this.worker !== null;
+  }
+
   /**
    * Load program source into interpreter
    */
-  loadProgram(source: string): { success: boolean; errors: string[] } {
-    if (!this.interpreter) {
+  async loadProgram(source: string): Promise<{ success: boolean; errors: string[] }> {
+    let diagnostics: Diagnostic[];
+    if (this.worker) {
+      diagnostics = await this.worker.load(source, {
+        speed: this.speed,
+        turbo: this.turbo,
+        maxRecursionDepth: this.maxRecursionDepth,
+        budget: this.budget,
+      });
+    } else if (this.interpreter) {
+      diagnostics = this.interpreter.load(source);
+    } else {
       return { success: false, errors: ["Interpreter not initialized"] };
     }
 
-    const diagnostics = this.interpreter.load(source);
     const errors = diagnostics.filter((d) => d.severity === "error").map((d) => d.message);
 
     return { success: errors.length === 0, errors };
@@ -49,13 +106,14 @@ export class ExecutionService {
    * Start continuous execution
    */
   async run(): Promise<void> {
-    if (!this.interpreter) {
+    const backend = this.worker ?? this.interpreter;
+    if (!backend) {
       throw new Error("Interpreter not initialized");
     }
 
     this.isRunning = true;
     try {
-      await this.interpreter.run();
+      await backend.run();
     } finally {
       this.isRunning = false;
     }
@@ -64,21 +122,21 @@ export class ExecutionService {
   /**
    * Execute a single step
    */
-  step(): boolean {
-    if (!this.interpreter) {
+  async step(): Promise<boolean> {
+    const backend = this.worker ?? this.interpreter;
+    if (!backend) {
       throw new Error("Interpreter not initialized");
     }
 
-    return this.interpreter.step();
+    return backend.step();
   }
 
   /**
    * Stop execution
    */
   stop(): void {
-    if (this.interpreter) {
-      this.interpreter.stop();
-    }
+    this.worker?.stop();
+    this.interpreter?.stop();
     this.isRunning = false;
   }
 
@@ -86,9 +144,8 @@ export class ExecutionService {
    * Reset interpreter and world
    */
   reset(): void {
-    if (this.interpreter) {
-      this.interpreter.reset();
-    }
+    this.worker?.reset();
+    this.interpreter?.reset();
     this.isRunning = false;
   }
 
@@ -96,9 +153,41 @@ export class ExecutionService {
    * Set execution speed
    */
   setSpeed(ms: number): void {
-    if (this.interpreter) {
-      this.interpreter.setSpeed(ms);
-    }
+    this.speed = ms;
+    this.worker?.setSpeed(ms);
+    this.interpreter?.setSpeed(ms);
+  }
+
+  /**
+   * Enable or disable turbo mode (applies to the next loaded program in a worker)
+   */
+  setTurbo(enabled: boolean): void {
+    this.turbo = enabled;
+    this.interpreter?.setTurbo(enabled);
+  }
+
+  /**
+   * Set the recursion depth limit (applies to the next loaded program in a worker)
+   */
+  setMaxRecursionDepth(depth: number): void {
+    this.maxRecursionDepth = depth;
+    this.interpreter?.setMaxRecursionDepth(depth);
+  }
+
+  /**
+   * Set the step and control budget (applies to the next loaded program in a worker)
+   */
+  setBudget(budget: ExecutionBudget): void {
+    this.budget = budget;
+    this.interpreter?.setBudget(budget);
+  }
+
+  /**
+   * Allow another full budget after a pause; run() then continues
+   */
+  extendBudget(): void {
+    this.worker?.extendBudget();
+    this.interpreter?.extendBudget();
   }
 
   /**
@@ -112,37 +201,52 @@ export class ExecutionService {
    * Check if step mode is initialized
    */
   isStepInitialized(): boolean {
-    return this.interpreter?.isStepInitialized() ?? false;
+    return (this.worker ?? this.interpreter)?.isStepInitialized() ?? false;
   }
 
   /**
    * Check if execution is completed
    */
   isCompleted(): boolean {
-    return this.interpreter?.isStepCompleted() ?? false;
+    return (this.worker ?? this.interpreter)?.isStepCompleted() ?? false;
   }
 
   /**
    * Setup interpreter callbacks
    */
   private setupCallbacks(): void {
-    if (!this.interpreter) {
+    const backend = this.worker ?? this.interpreter;
+    if (!backend) {
       return;
     }
 
-    this.interpreter.onStep = (line: number) => {
+    backend.onStep = (line: number) => {
       this.onStep?.(line);
     };
 
-    this.interpreter.onComplete = () => {
+    backend.onSlice = (line: number) => {
+      this.onSlice?.(line);
+    };
+
+    backend.onComplete = () => {
       this.isRunning = false;
       this.onComplete?.();
     };
 
-    this.interpreter.onError = (error: RuntimeError) => {
+    backend.onError = (error: RuntimeError) => {
       this.isRunning = false;
       this.onError?.(error);
     };
+
+    backend.onBudgetExhausted = (message: string) => {
+      this.isRunning = false;
+      this.onBudgetExhausted?.(message);
+    };
+  }
+
+  private disposeWorker(): void {
+    this.worker?.dispose();
+    this.worker = null;
   }
 
   /**
@@ -150,6 +254,7 @@ export class ExecutionService {
    */
   dispose(): void {
     this.stop();
+    this.disposeWorker();
     this.interpreter = null;
   }
 }
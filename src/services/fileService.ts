@@ -49,6 +49,48 @@ export class FileService {
     return files?.[0];
   }
 
+  /**
+   * Prompt user to select a folder of Karel map files
+   */
+  async selectMapFolder(): Promise<vscode.Uri | undefined> {
+    const folders = await vscode.window.showOpenDialog({
+      canSelectMany: false,
+      canSelectFiles: false,
+      canSelectFolders: true,
+      title: UIMessages.selectMapFolder(),
+    });
+
+    return folders?.[0];
+  }
+
+  /**
+   * Prompt user to select an execution trace (.kltrace)
+   */
+  async selectTraceFile(): Promise<vscode.Uri | undefined> {
+    const files = await vscode.window.showOpenDialog({
+      canSelectMany: false,
+      filters: {
+        "Karel Traces": ["kltrace"],
+      },
+      title: UIMessages.selectTraceFile(),
+    });
+
+    return files?.[0];
+  }
+
+  /**
+   * Prompt user for where to save an execution trace (.kltrace)
+   */
+  async selectTraceSaveLocation(defaultUri?: vscode.Uri): Promise<vscode.Uri | undefined> {
+    return vscode.window.showSaveDialog({
+      defaultUri,
+      filters: {
+        "Karel Traces": ["kltrace"],
+      },
+      title: UIMessages.saveTraceFile(),
+    });
+  }
+
   /**
    * Prompt for and load an instructions file, opening it in the editor.
    * Returns the opened document or undefined if cancelled/failed.
@@ -6,3 +6,5 @@ export { StateManager } from "./stateManager";
 export { FileService } from "./fileService";
 export { WorldService } from "./worldService";
 export { ExecutionService } from "./executionService";
+export { WorkerExecutionBackend } from "./workerExecutionBackend";
+export { TracePlaybackService } from "./tracePlaybackService";
@@ -5,12 +5,16 @@
 
 import * as vscode from "vscode";
 import { World, Interpreter } from "@/interpreter";
+import { ExecutionService } from "@/services/executionService";
+import { TracePlaybackService } from "@/services/tracePlaybackService";
 
 export class StateManager {
   private static instance: StateManager;
 
   public world: World | null = null;
   public interpreter: Interpreter | null = null;
+  public execution: ExecutionService | null = null; // worker_thread execution, if active
+  public playback: TracePlaybackService | null = null; // precomputed run or replayed trace
   public sourceDocument: vscode.TextDocument | null = null;
   public outputChannel: vscode.OutputChannel;
   public executionLineDecoration: vscode.TextEditorDecorationType;
@@ -43,6 +47,14 @@ export class StateManager {
   public reset(): void {
     this.world = null;
     this.interpreter = null;
+    this.execution?.dispose();
+    this.execution = null;
+    this.disposePlayback();
     this.sourceDocument = null;
   }
+
+  public disposePlayback(): void {
+    this.playback?.pause();
+    this.playback = null;
+  }
 }
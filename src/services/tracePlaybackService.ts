@@ -0,0 +1,98 @@
+/**
+ * Trace Playback Service
+ * Animates a recorded trace onto a world, with seeking
+ */
+
+import { World, TracePlayer, TraceEnd } from "@/interpreter";
+
+/**
+ * Time budget of one turbo playback frame.
+ */
+const TURBO_FRAME_MS = 16;
+
+export class TracePlaybackService {
+  private readonly world: World;
+  private readonly player: TracePlayer;
+  private playing: boolean = false;
+  private generation: number = 0; // invalidates a paused play() loop
+
+  // Callbacks
+  public onFrame?: (position: number, line: number) => void;
+  public onEnd?: (end: TraceEnd | null) => void;
+
+  constructor(world: World, player: TracePlayer) {
+    this.world = world;
+    this.player = player;
+  }
+
+  /**
+   * Number of steps in the trace
+   */
+  get totalSteps(): number {
+    return this.player.totalSteps;
+  }
+
+  /**
+   * How the traced run ended
+   */
+  get end(): TraceEnd | null {
+    return this.player.end;
+  }
+
+  /**
+   * Check if the animation is in progress
+   */
+  isPlaying(): boolean {
+    return this.playing;
+  }
+
+  /**
+   * Animate from the current position to the end.
+   * Animated mode shows every step with a delay, turbo shows one frame per
+   * time slice. Seeking while playing continues from the new position.
+   */
+  async play(speed: number, turbo: boolean): Promise<void> {
+    const generation = ++this.generation;
+    this.playing = true;
+
+    while (this.playing && generation === this.generation) {
+      const deadline = performance.now() + TURBO_FRAME_MS;
+      let line = 0;
+      let more: boolean;
+      do {
+        const step = this.player.step(this.world);
+        more = step !== null;
+        line = step?.line ?? line;
+      } while (more && turbo && performance.now() < deadline);
+
+      if (line > 0) {
+        this.onFrame?.(this.player.position, line);
+      }
+      if (!more) {
+        this.playing = false;
+        this.onEnd?.(this.player.end);
+        break;
+      }
+      await new Promise((resolve) => setTimeout(resolve, turbo ? 0 : speed));
+    }
+  }
+
+  /**
+   * Stop animating (the position is kept, so seeking still works)
+   */
+  pause(): void {
+    this.playing = false;
+    this.generation++;
+  }
+
+  /**
+   * Jump to the state after `step` steps
+   */
+  seek(step: number): void {
+    const line = this.player.seek(this.world, step);
+    this.onFrame?.(this.player.position, line);
+    if (!this.playing && this.player.position === this.player.totalSteps) {
+      this.onEnd?.(this.player.end);
+    }
+  }
+}
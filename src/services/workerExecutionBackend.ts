@@ -0,0 +1,213 @@
+/**
+ * Worker Execution Backend
+ * Runs the interpreter on a worker_thread and mirrors its state into a local World
+ */
+
+import { Worker } from "worker_threads";
+import { World, RuntimeError, Diagnostic, ExecutionBudget } from "@/interpreter";
+import {
+  CONTROL_SLOTS,
+  ControlSlot,
+  WorkerInitData,
+  WorkerRequest,
+  WorkerResponse,
+} from "@/interpreter/worker/protocol";
+
+export interface WorkerLoadOptions {
+  speed: number;
+  turbo: boolean;
+  maxRecursionDepth: number;
+  budget: ExecutionBudget;
+}
+
+export class WorkerExecutionBackend {
+  private worker: Worker;
+  private control: Int32Array;
+  private world: World;
+  private stepInitialized: boolean = false;
+  private completed: boolean = false;
+
+  private pendingLoad: ((diagnostics: Diagnostic[]) => void) | null = null;
+  private pendingStep: ((hasMore: boolean) => void) | null = null;
+  private pendingRun: (() => void) | null = null;
+
+  // Callbacks (same meaning as the Interpreter callbacks)
+  public onStep?: (line: number) => void;
+  public onSlice?: (line: number) => void;
+  public onComplete?: () => void;
+  public onError?: (error: RuntimeError) => void;
+  public onBudgetExhausted?: (message: string) => void;
+
+  /**
+   * @param world - Local world that receives the worker's state snapshots
+   * @param scriptPath - Path of the bundled worker script (dist/karelWorker.js)
+   */
+  constructor(world: World, scriptPath: string) {
+    this.world = world;
+
+    const buffer = new SharedArrayBuffer(CONTROL_SLOTS * Int32Array.BYTES_PER_ELEMENT);
+    this.control = new Int32Array(buffer);
+
+    const initData: WorkerInitData = { control: buffer };
+    this.worker = new Worker(scriptPath, { workerData: initData });
+    this.worker.on("message", (message: WorkerResponse) => this.handleMessage(message));
+    this.worker.on("error", (error) => this.handleFailure(error.message));
+    this.worker.on("exit", (code) => {
+      if (code !== 0) {
+        this.handleFailure(`Interpreter worker exited with code ${code}`);
+      }
+    });
+  }
+
+  /**
+   * Load the current world state and a program into the worker.
+   */
+  load(source: string, options: WorkerLoadOptions): Promise<Diagnostic[]> {
+    this.stepInitialized = false;
+    this.completed = false;
+    return new Promise((resolve) => {
+      this.pendingLoad = resolve;
+      this.post({
+        type: "load",
+        map: this.world.toJSON(),
+        source,
+        speed: options.speed,
+        turbo: options.turbo,
+        maxRecursionDepth: options.maxRecursionDepth,
+        budget: options.budget,
+      });
+    });
+  }
+
+  /**
+   * Run until completion, error or stop.
+   */
+  run(): Promise<void> {
+    this.stepInitialized = true;
+    Atomics.store(this.control, ControlSlot.Interrupt, 0);
+    return new Promise((resolve) => {
+      this.pendingRun = resolve;
+      this.post({ type: "run" });
+    });
+  }
+
+  /**
+   * Execute a single step. Resolves to true if there are more steps.
+   */
+  step(): Promise<boolean> {
+    this.stepInitialized = true;
+    Atomics.store(this.control, ControlSlot.Interrupt, 0);
+    return new Promise((resolve) => {
+      this.pendingStep = resolve;
+      this.post({ type: "step" });
+    });
+  }
+
+  /**
+   * Stop execution. Takes effect inside the current batch, not after it.
+   */
+  stop(): void {
+    Atomics.store(this.control, ControlSlot.Interrupt, 1);
+    this.post({ type: "stop" });
+  }
+
+  /**
+   * Reset the worker's interpreter and world.
+   */
+  reset(): void {
+    this.stop();
+    this.stepInitialized = false;
+    this.completed = false;
+    this.post({ type: "reset" });
+  }
+
+  setSpeed(ms: number): void {
+    this.post({ type: "speed", ms });
+  }
+
+  /**
+   * Allow another full budget after a pause; run() then continues.
+   */
+  extendBudget(): void {
+    this.post({ type: "extendBudget" });
+  }
+
+  isStepInitialized(): boolean {
+    return this.stepInitialized;
+  }
+
+  isStepCompleted(): boolean {
+    return this.completed;
+  }
+
+  /**
+   * Terminate the worker.
+   */
+  dispose(): void {
+    this.worker.removeAllListeners();
+    this.worker.terminate();
+    this.settlePending();
+  }
+
+  private post(request: WorkerRequest): void {
+    this.worker.postMessage(request);
+  }
+
+  private handleMessage(message: WorkerResponse): void {
+    switch (message.type) {
+      case "loaded":
+        this.pendingLoad?.(message.diagnostics);
+        this.pendingLoad = null;
+        break;
+      case "state":
+        if (message.delta) {
+          this.world.applyDelta(message.delta, message.isModified);
+        } else if (message.world) {
+          this.world.loadState(message.world, message.isModified);
+        }
+        if (message.event === "step") {
+          this.onStep?.(message.line);
+        } else if (message.event === "slice") {
+          this.onSlice?.(message.line);
+        }
+        break;
+      case "complete":
+        this.completed = true;
+        this.onComplete?.();
+        break;
+      case "error":
+        this.completed = true;
+        this.onError?.(new RuntimeError(message.message, message.line));
+        break;
+      case "paused":
+        this.onBudgetExhausted?.(message.message);
+        break;
+      case "stepped":
+        this.pendingStep?.(message.hasMore);
+        this.pendingStep = null;
+        break;
+      case "finished":
+        this.pendingRun?.();
+        this.pendingRun = null;
+        break;
+    }
+  }
+
+  private handleFailure(message: string): void {
+    this.completed = true;
+    this.onError?.(new RuntimeError(message));
+    this.settlePending();
+  }
+
+  /**
+   * Resolve outstanding requests so callers never wait on a dead worker.
+   */
+  private settlePending(): void {
+    this.pendingLoad?.([]);
+    this.pendingStep?.(false);
+    this.pendingRun?.();
+    this.pendingLoad = null;
+    this.pendingStep = null;
+    this.pendingRun = null;
+  }
+}
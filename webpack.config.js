@@ -2,15 +2,24 @@
 "use strict";
 
 const path = require("path");
+const webpack = require("webpack");
 
 /** @type {import('webpack').Configuration} */
 const config = {
   target: "node",
   mode: "none",
-  entry: "./src/extension.ts",
+  entry: {
+    extension: "./src/extension.ts",
+    // Interpreter worker_thread, loaded from dist/ at runtime
+    karelWorker: "./src/interpreter/worker/karelWorker.ts",
+    // Batch runner pool worker, used by the runBatch command and the CLI
+    batchWorker: "./src/interpreter/batch/batchWorker.ts",
+    // Headless command-line runner (node dist/cli.js), no vscode dependency
+    cli: "./src/cli/cli.ts",
+  },
   output: {
     path: path.resolve(__dirname, "dist"),
-    filename: "extension.js",
+    filename: "[name].js",
     libraryTarget: "commonjs2",
   },
   externals: {
@@ -35,6 +44,14 @@ const config = {
       },
     ],
   },
+  plugins: [
+    new webpack.BannerPlugin({
+      banner: "#!/usr/bin/env node",
+      raw: true,
+      entryOnly: true,
+      include: /^cli\.js$/,
+    }),
+  ],
   devtool: "nosources-source-map",
   infrastructureLogging: {
     level: "log",